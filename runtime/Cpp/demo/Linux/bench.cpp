@@ -0,0 +1,280 @@
+/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+//
+//  bench.cpp
+//  antlr4-cpp-demo
+//
+//  Timing drivers for the runtime, using the demo grammars. Run without arguments for a list of the benchmarks.
+//
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "antlr4-runtime.h"
+#include "TLexer.h"
+#include "TParser.h"
+
+using namespace antlrcpptest;
+using namespace antlr4;
+
+namespace {
+
+  typedef std::chrono::steady_clock Clock;
+
+  const size_t ROUNDS = 5;
+
+  double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+  /// Statements of the demo grammar, repeated until there are {@code statements} of them. With {@code nonAscii}
+  /// every other statement has identifiers with Latin-1 letters.
+  std::string makeInput(size_t statements, bool nonAscii = false) {
+    static const char *lines[] = {
+      "a = b + (c * 12);\n",
+      "result = (x * (y ? 0 : 1) + z);\n",
+      "return value + 42;\n",
+      "name = \"some text\" * (first + second);\n",
+      "# a comment line\n",
+      "counter = counter + 1;\n",
+    };
+    const size_t lineCount = sizeof(lines) / sizeof(lines[0]);
+
+    std::string result;
+    for (size_t i = 0; i < statements; ++i) {
+      if (nonAscii && i % 2 == 1) {
+        result += "gr\xC3\xB6\xC3\x9F" "e = ma\xC3\x9F * (l\xC3\xA4nge + 2);\n"; // größe = maß * (länge + 2);
+      } else {
+        result += lines[i % lineCount];
+      }
+    }
+    return result;
+  }
+
+  void report(const std::string &name, double count, const std::string &unit, double seconds) {
+    std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(2)
+      << std::setw(10) << count / seconds / 1e6 << " M" << unit << "/s" << std::endl;
+  }
+
+  /// Tokens per second for the different ways of getting tokens from a lexer. The lexer DFA is warmed up first, so
+  /// this measures the token loop, not the DFA construction. Each number is the best of ROUNDS rounds.
+  int benchTokens(size_t statements) {
+    ANTLRInputStream input(makeInput(statements));
+    TLexer lexer(&input);
+    {
+      CommonTokenStream tokens(&lexer);
+      tokens.fill();
+    }
+
+    double best = 0;
+    size_t count = 0;
+    for (size_t round = 0; round < ROUNDS; ++round) {
+      lexer.reset();
+      Clock::time_point start = Clock::now();
+      count = 0;
+      while (true) {
+        std::unique_ptr<Token> token = lexer.nextToken();
+        ++count;
+        if (token->getType() == Token::EOF) {
+          break;
+        }
+      }
+      double seconds = secondsSince(start);
+      best = round == 0 ? seconds : std::min(best, seconds);
+    }
+    report("nextToken() loop", count, "tokens", best);
+
+    lexer.setTokenBatchingEnabled(true);
+    std::vector<std::unique_ptr<Token>> batch;
+    batch.reserve(1000);
+    for (size_t round = 0; round < ROUNDS; ++round) {
+      lexer.reset();
+      Clock::time_point start = Clock::now();
+      count = 0;
+      while (true) {
+        batch.clear();
+        count += lexer.nextTokens(batch, 1000);
+        if (batch.back()->getType() == Token::EOF) {
+          break;
+        }
+      }
+      double seconds = secondsSince(start);
+      best = round == 0 ? seconds : std::min(best, seconds);
+    }
+    report("nextTokens(), batches of 1000", count, "tokens", best);
+
+    for (bool batching : { false, true }) {
+      lexer.setTokenBatchingEnabled(batching);
+      for (size_t round = 0; round < ROUNDS; ++round) {
+        lexer.reset();
+        Clock::time_point start = Clock::now();
+        CommonTokenStream tokens(&lexer);
+        tokens.fill();
+        count = tokens.size();
+        double seconds = secondsSince(start);
+        best = round == 0 ? seconds : std::min(best, seconds);
+      }
+      report(batching ? "CommonTokenStream::fill(), batching" : "CommonTokenStream::fill()", count, "tokens", best);
+    }
+
+    return 0;
+  }
+
+  /// Characters per second of the lexer with a warm DFA, so nearly every character is a DFA edge lookup. Run it with
+  /// runtimes built with different ANTLR4_LEXER_MAX_DFA_EDGE values to compare the width of the edge table.
+  int benchChars(size_t statements) {
+    std::cout << "Lexer DFA edges for symbols " << atn::LexerATNSimulator::MIN_DFA_EDGE << ".."
+      << atn::LexerATNSimulator::MAX_DFA_EDGE << std::endl;
+
+    for (bool nonAscii : { false, true }) {
+      ANTLRInputStream input(makeInput(statements, nonAscii));
+      TLexer lexer(&input);
+      double best = 0;
+      for (size_t round = 0; round <= ROUNDS; ++round) {
+        lexer.reset();
+        Clock::time_point start = Clock::now();
+        while (lexer.nextToken()->getType() != Token::EOF) {
+        }
+        double seconds = secondsSince(start);
+
+        // The first round warms up the DFA and is not counted.
+        if (round == 1 || (round > 1 && seconds < best)) {
+          best = seconds;
+        }
+      }
+      report(nonAscii ? "ASCII and Latin-1 input" : "ASCII input", static_cast<double>(input.size()), "chars", best);
+    }
+
+    return 0;
+  }
+
+  /// Input for a parser thread, tokenized before the clock starts.
+  struct ParserInput {
+    ANTLRInputStream input;
+    TLexer lexer;
+    CommonTokenStream tokens;
+
+    ParserInput(const std::string &text) : input(text), lexer(&input), tokens(&lexer) {
+      tokens.fill();
+    }
+  };
+
+  /// Runs {@code lexerThreads} threads which tokenize {@code text} with TLexer and {@code parserThreads} threads
+  /// which parse it with TParser, all starting at the same time with empty DFAs. Returns the seconds until all
+  /// threads are done.
+  double warmUp(const std::string &text, size_t lexerThreads, size_t parserThreads) {
+    std::vector<std::unique_ptr<ParserInput>> parserInputs;
+    for (size_t i = 0; i < parserThreads; ++i) {
+      parserInputs.emplace_back(new ParserInput(text));
+    }
+
+    // The DFAs are shared by all instances of a recognizer class, so clearing them through one instance is enough.
+    ANTLRInputStream emptyInput;
+    TLexer emptyLexer(&emptyInput);
+    CommonTokenStream emptyTokens(&emptyLexer);
+    TParser emptyParser(&emptyTokens);
+    emptyLexer.getInterpreter<atn::LexerATNSimulator>()->clearDFA();
+    emptyParser.getInterpreter<atn::ParserATNSimulator>()->clearDFA();
+
+    std::atomic<bool> started(false);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < lexerThreads; ++i) {
+      threads.emplace_back([&text, &started]() {
+        ANTLRInputStream input(text);
+        TLexer lexer(&input);
+        while (!started) {
+          std::this_thread::yield();
+        }
+        while (lexer.nextToken()->getType() != Token::EOF) {
+        }
+      });
+    }
+    for (size_t i = 0; i < parserThreads; ++i) {
+      ParserInput *parserInput = parserInputs[i].get();
+      threads.emplace_back([parserInput, &started]() {
+        TParser parser(&parserInput->tokens);
+        while (!started) {
+          std::this_thread::yield();
+        }
+        parser.main();
+      });
+    }
+
+    Clock::time_point start = Clock::now();
+    started = true;
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+    return secondsSince(start);
+  }
+
+  /// DFA warm-up in two grammars at once: the lexer grammar TLexer and the parser grammar TParser, each used by
+  /// {@code threads} threads which start with empty DFAs. If building the DFA of one grammar does not stall the other,
+  /// running both takes about as long as the slower of the two alone (given enough cores).
+  int benchWarmUp(size_t statements, size_t threads) {
+    std::string text = makeInput(statements);
+
+    struct Setup {
+      const char *name;
+      size_t lexerThreads;
+      size_t parserThreads;
+    };
+    const Setup setups[] = {
+      { "lexer threads alone", threads, 0 },
+      { "parser threads alone", 0, threads },
+      { "lexer and parser threads together", threads, threads },
+    };
+
+    std::cout << threads << " thread(s) per grammar, " << statements << " statements each" << std::endl;
+    for (const Setup &setup : setups) {
+      double best = 0;
+      for (size_t round = 0; round < ROUNDS; ++round) {
+        double seconds = warmUp(text, setup.lexerThreads, setup.parserThreads);
+        best = round == 0 ? seconds : std::min(best, seconds);
+      }
+      std::cout << std::left << std::setw(40) << setup.name << std::right << std::fixed << std::setprecision(2)
+        << std::setw(10) << best * 1000 << " ms" << std::endl;
+    }
+
+    return 0;
+  }
+
+  int usage() {
+    std::cerr << "usage: antlr4-bench <benchmark> [statements] [threads]" << std::endl << std::endl
+      << "  tokens   tokens/s of nextToken() compared to batched nextTokens() and CommonTokenStream::fill()"
+      << std::endl
+      << "  chars    chars/s of the lexer with a warm DFA, for ASCII and for partly Latin-1 input" << std::endl
+      << "  warmup   time to build the DFAs of the lexer and the parser grammar from several threads at once"
+      << std::endl;
+    return 1;
+  }
+
+} // namespace
+
+int main(int argc, const char **argv) {
+  if (argc < 2) {
+    return usage();
+  }
+
+  std::string benchmark = argv[1];
+  // Warming up the DFAs needs far less input than measuring throughput.
+  size_t statements = argc > 2 ? std::stoul(argv[2]) : (benchmark == "warmup" ? 5000 : 200000);
+  size_t threads = argc > 3 ? std::stoul(argv[3]) : std::max(1u, std::thread::hardware_concurrency() / 2);
+
+  if (benchmark == "tokens") {
+    return benchTokens(statements);
+  }
+  if (benchmark == "chars") {
+    return benchChars(statements);
+  }
+  if (benchmark == "warmup") {
+    return benchWarmUp(statements, threads);
+  }
+  return usage();
+}
@@ -8,7 +8,9 @@
 #include "IntStream.h"
 
 #include "support/StringUtils.h"
+#include "support/Unicode.h"
 #include "support/CPPUtils.h"
+#include "LineIndex.h"
 
 #include "ANTLRInputStream.h"
 
@@ -41,18 +43,16 @@ void ANTLRInputStream::load(std::string_view input) {
   constexpr std::string_view bom = "\xef\xbb\xbf";
   if (input.compare(0, 3, bom) == 0)
     input.remove_prefix(3);
-  _data = antlrcpp::utf8_to_utf32(input.data(), input.data() + input.size());
-  p = 0;
+  setData(input.data(), input.data() + input.size());
 }
 #else
 void ANTLRInputStream::load(const std::string &input) {
   // Remove the UTF-8 BOM if present.
   const char bom[4] = "\xef\xbb\xbf";
   if (input.compare(0, 3, bom, 3) == 0)
-    _data = antlrcpp::utf8_to_utf32(input.data() + 3, input.data() + input.size());
+    setData(input.data() + 3, input.data() + input.size());
   else
-    _data = antlrcpp::utf8_to_utf32(input.data(), input.data() + input.size());
-  p = 0;
+    setData(input.data(), input.data() + input.size());
 }
 #endif
 
@@ -60,7 +60,7 @@ void ANTLRInputStream::load(std::istream &stream) {
   if (!stream.good() || stream.eof()) // No fail, bad or EOF.
     return;
 
-  _data.clear();
+  setData(nullptr, nullptr);
 
   std::string s((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
   load(s);
@@ -71,12 +71,12 @@ void ANTLRInputStream::reset() {
 }
 
 void ANTLRInputStream::consume() {
-  if (p >= _data.size()) {
+  if (p >= _size) {
     assert(LA(1) == IntStream::EOF);
     throw IllegalStateException("cannot consume EOF");
   }
 
-  if (p < _data.size()) {
+  if (p < _size) {
     p++;
   }
 }
@@ -94,11 +94,19 @@ size_t ANTLRInputStream::LA(ssize_t i) {
     }
   }
 
-  if ((position + i - 1) >= static_cast<ssize_t>(_data.size())) {
+  if ((position + i - 1) >= static_cast<ssize_t>(_size)) {
     return IntStream::EOF;
   }
 
-  return _data[static_cast<size_t>((position + i - 1))];
+  size_t index = static_cast<size_t>(position + i - 1);
+  switch (_width) {
+    case 1:
+      return static_cast<unsigned char>(_data8[index]);
+    case 2:
+      return _data16[index];
+    default:
+      return static_cast<size_t>(_data32[index]);
+  }
 }
 
 size_t ANTLRInputStream::LT(ssize_t i) {
@@ -110,7 +118,7 @@ size_t ANTLRInputStream::index() {
 }
 
 size_t ANTLRInputStream::size() {
-  return _data.size();
+  return _size;
 }
 
 // Mark/release do nothing. We have entire buffer.
@@ -127,31 +135,69 @@ void ANTLRInputStream::seek(size_t index) {
     return;
   }
   // seek forward, consume until p hits index or n (whichever comes first)
-  index = std::min(index, _data.size());
+  index = std::min(index, _size);
   while (p < index) {
     consume();
   }
 }
 
 std::string ANTLRInputStream::getText(const Interval &interval) {
-  if (interval.a < 0 || interval.b < 0) {
+  if (interval.a < 0 || interval.b < interval.a) {
     return "";
   }
 
   size_t start = static_cast<size_t>(interval.a);
   size_t stop = static_cast<size_t>(interval.b);
 
-
-  if (stop >= _data.size()) {
-    stop = _data.size() - 1;
+  if (stop >= _size) {
+    stop = _size - 1;
   }
 
   size_t count = stop - start + 1;
-  if (start >= _data.size()) {
+  if (start >= _size) {
     return "";
   }
 
-  return antlrcpp::utf32_to_utf8(_data.substr(start, count));
+  switch (_width) {
+    case 1: {
+      const unsigned char *first = reinterpret_cast<const unsigned char *>(_data8.data()) + start;
+      return antlrcpp::encodeUtf8(first, first + count);
+    }
+    case 2:
+      return antlrcpp::encodeUtf8(_data16.data() + start, _data16.data() + start + count);
+    default: {
+      const char32_t *first = reinterpret_cast<const char32_t *>(_data32.data()) + start;
+      return antlrcpp::encodeUtf8(first, first + count);
+    }
+  }
+}
+
+bool ANTLRInputStream::getTextView(const Interval &interval, antlrcpp::StringView &text) {
+  if (interval.a < 0 || interval.b < interval.a) {
+    text = antlrcpp::StringView();
+    return true;
+  }
+
+  size_t start = static_cast<size_t>(interval.a);
+  if (start >= _size) {
+    text = antlrcpp::StringView();
+    return true;
+  }
+  size_t stop = std::min(static_cast<size_t>(interval.b), _size - 1);
+
+  if (_width != 1) {
+    return false;
+  }
+
+  // Latin-1 characters above 0x7F take two bytes in UTF-8.
+  const char *first = _data8.data() + start;
+  size_t count = stop - start + 1;
+  if (antlrcpp::asciiPrefixLength(first, first + count) != count) {
+    return false;
+  }
+
+  text = antlrcpp::StringView(first, count);
+  return true;
 }
 
 std::string ANTLRInputStream::getSourceName() const {
@@ -162,9 +208,75 @@ std::string ANTLRInputStream::getSourceName() const {
 }
 
 std::string ANTLRInputStream::toString() const {
-  return antlrcpp::utf32_to_utf8(_data);
+  switch (_width) {
+    case 1: {
+      const unsigned char *first = reinterpret_cast<const unsigned char *>(_data8.data());
+      return antlrcpp::encodeUtf8(first, first + _size);
+    }
+    case 2:
+      return antlrcpp::encodeUtf8(_data16.data(), _data16.data() + _size);
+    default:
+      return antlrcpp::utf32_to_utf8(_data32);
+  }
+}
+
+const LineIndex* ANTLRInputStream::getLineIndex() {
+  if (_lineIndex == nullptr) {
+    switch (_width) {
+      case 1:
+        _lineIndex = std::make_shared<LineIndex>(reinterpret_cast<const unsigned char *>(_data8.data()), _size);
+        break;
+      case 2:
+        _lineIndex = std::make_shared<LineIndex>(_data16.data(), _size);
+        break;
+      default:
+        _lineIndex = std::make_shared<LineIndex>(reinterpret_cast<const char32_t *>(_data32.data()), _size);
+        break;
+    }
+  }
+  return _lineIndex.get();
+}
+
+size_t ANTLRInputStream::getCodePointWidth() const {
+  return _width;
 }
 
 void ANTLRInputStream::InitializeInstanceFields() {
+  _width = 1;
+  _size = 0;
   p = 0;
 }
+
+void ANTLRInputStream::setData(const char *first, const char *last) {
+  _data8.clear();
+  _data16.clear();
+  _data32.clear();
+  _lineIndex.reset();
+  p = 0;
+
+  // Pure ASCII input is stored as is, without decoding it first.
+  if (antlrcpp::asciiPrefixLength(first, last) == static_cast<size_t>(last - first)) {
+    _data8.assign(first, last);
+    _width = 1;
+    _size = _data8.size();
+    return;
+  }
+
+  // Find the largest code point first, so the text is decoded only once, straight into the narrowest storage.
+  uint32_t maxCodePoint;
+  size_t size = antlrcpp::scanUtf8(first, last, maxCodePoint);
+  if (maxCodePoint <= 0xFF) {
+    _width = 1;
+    _data8.resize(size);
+    antlrcpp::decodeUtf8(first, last, &_data8[0]);
+  } else if (maxCodePoint <= 0xFFFF) {
+    _width = 2;
+    _data16.resize(size);
+    antlrcpp::decodeUtf8(first, last, &_data16[0]);
+  } else {
+    _width = 4;
+    _data32.resize(size);
+    antlrcpp::decodeUtf8(first, last, &_data32[0]);
+  }
+  _size = size;
+}
@@ -11,16 +11,26 @@ namespace antlr4 {
 
   // Vacuum all input from a stream and then treat it
   // like a string. Can also pass in a string or char[] to use.
-  // Input is expected to be encoded in UTF-8 and converted to UTF-32 internally.
+  // Input is expected to be encoded in UTF-8 and converted to code points internally.
+  // The code points are stored with 1, 2 or 4 bytes each, depending on the largest one in the input.
   class ANTLR4CPP_PUBLIC ANTLRInputStream : public CharStream {
   protected:
-    /// The data being scanned.
-    // UTF-32
-    UTF32String _data;
+    /// The data being scanned. Only one of these is used, the narrowest that can hold all code points:
+    /// Latin-1 (_width 1), UCS-2 (_width 2) or UTF-32 (_width 4).
+    std::string _data8;
+    std::u16string _data16;
+    UTF32String _data32;
+    size_t _width;
+
+    /// The number of code points in the data.
+    size_t _size;
 
     /// 0..n-1 index into string of next char </summary>
     size_t p;
 
+    /// Built by getLineIndex() and dropped when the data changes.
+    std::shared_ptr<LineIndex> _lineIndex;
+
   public:
     /// What is name or source of this char stream?
     std::string name;
@@ -67,11 +77,20 @@ namespace antlr4 {
     /// </summary>
     virtual void seek(size_t index) override;
     virtual std::string getText(const misc::Interval &interval) override;
+
+    /// Views are available for text which is stored as ASCII, i.e. for all of an ASCII input and for the ASCII
+    /// parts of other Latin-1 input.
+    virtual bool getTextView(const misc::Interval &interval, antlrcpp::StringView &text) override;
     virtual std::string getSourceName() const override;
     virtual std::string toString() const override;
+    virtual const LineIndex* getLineIndex() override;
+
+    /// Returns the number of bytes used for each code point (1, 2 or 4).
+    size_t getCodePointWidth() const;
 
   private:
     void InitializeInstanceFields();
+    void setData(const char *first, const char *last);
   };
 
 } // namespace antlr4
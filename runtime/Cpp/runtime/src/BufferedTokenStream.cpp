@@ -9,6 +9,7 @@
 #include "misc/Interval.h"
 #include "Exceptions.h"
 #include "support/CPPUtils.h"
+#include "TokenStore.h"
 
 #include "BufferedTokenStream.h"
 
@@ -19,6 +20,9 @@ BufferedTokenStream::BufferedTokenStream(TokenSource *tokenSource) : _tokenSourc
   InitializeInstanceFields();
 }
 
+BufferedTokenStream::~BufferedTokenStream() {
+}
+
 TokenSource* BufferedTokenStream::getTokenSource() const {
   return _tokenSource;
 }
@@ -91,24 +95,40 @@ size_t BufferedTokenStream::fetch(size_t n) {
     return 0;
   }
 
-  size_t i = 0;
-  while (i < n) {
-    std::unique_ptr<Token> t(_tokenSource->nextToken());
+  size_t first = _tokens.size();
+  try {
+    _tokenSource->nextTokens(_tokens, n);
+  } catch (...) {
+    // Keep the tokens which were created before the token source failed.
+    addFetchedTokens(first);
+    throw;
+  }
+
+  return addFetchedTokens(first);
+}
 
+size_t BufferedTokenStream::addFetchedTokens(size_t first) {
+  for (size_t i = first; i < _tokens.size(); ++i) {
+    std::unique_ptr<Token> &t = _tokens[i];
     if (is<WritableToken *>(t.get())) {
-      (static_cast<WritableToken *>(t.get()))->setTokenIndex(_tokens.size());
+      (static_cast<WritableToken *>(t.get()))->setTokenIndex(i);
     }
 
-    _tokens.push_back(std::move(t));
-    ++i;
+    if (_tokenStore != nullptr) {
+      std::unique_ptr<Token> compact = _tokenStore->add(*t);
+      if (compact != nullptr) {
+        t = std::move(compact);
+      }
+    }
 
-    if (_tokens.back()->getType() == Token::EOF) {
+    if (t->getType() == Token::EOF) {
       _fetchedEOF = true;
+      _tokens.resize(i + 1);
       break;
     }
   }
 
-  return i;
+  return _tokens.size() - first;
 }
 
 Token* BufferedTokenStream::get(size_t i) const {
@@ -192,10 +212,32 @@ void BufferedTokenStream::setup() {
 void BufferedTokenStream::setTokenSource(TokenSource *tokenSource) {
   _tokenSource = tokenSource;
   _tokens.clear();
+  if (_tokenStore != nullptr) {
+    _tokenStore->clear();
+  }
   _fetchedEOF = false;
   _needSetup = true;
 }
 
+void BufferedTokenStream::setCompactTokenStorage(bool enable) {
+  if (enable == hasCompactTokenStorage()) {
+    return;
+  }
+  if (!_tokens.empty()) {
+    throw IllegalStateException("compact token storage must be set before tokens are fetched");
+  }
+
+  if (enable) {
+    _tokenStore.reset(new TokenStore());
+  } else {
+    _tokenStore.reset();
+  }
+}
+
+bool BufferedTokenStream::hasCompactTokenStorage() const {
+  return _tokenStore != nullptr;
+}
+
 std::vector<Token *> BufferedTokenStream::getTokens() {
   std::vector<Token *> result;
   for (auto &t : _tokens)
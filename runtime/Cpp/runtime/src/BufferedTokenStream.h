@@ -25,6 +25,7 @@ namespace antlr4 {
   public:
     BufferedTokenStream(TokenSource *tokenSource);
     BufferedTokenStream(const BufferedTokenStream& other) = delete;
+    virtual ~BufferedTokenStream();
 
     BufferedTokenStream& operator = (const BufferedTokenStream& other) = delete;
 
@@ -94,12 +95,23 @@ namespace antlr4 {
     /// Get all tokens from lexer until EOF.
     virtual void fill();
 
+    /// Keeps the fetched tokens in a compact TokenStore instead of keeping the CommonToken objects created by the
+    /// token source, which saves memory and allocations for large inputs. Tokens which cannot be stored compactly
+    /// are kept as they are. Must be set before the first token is fetched (or after setTokenSource()).
+    /// @throws IllegalStateException if tokens were fetched already.
+    virtual void setCompactTokenStorage(bool enable);
+    bool hasCompactTokenStorage() const;
+
   protected:
     /**
      * The {@link TokenSource} from which tokens for this stream are fetched.
      */
     TokenSource *_tokenSource;
 
+    /// Holds the values of the tokens if compact token storage is enabled. Declared before _tokens, so that
+    /// the tokens are destroyed before the store.
+    std::unique_ptr<TokenStore> _tokenStore;
+
     /**
      * A collection of all tokens fetched from the token source. The list is
      * considered a complete view of the input once {@link #fetchedEOF} is set
@@ -151,6 +163,10 @@ namespace antlr4 {
     /// <returns> The actual number of elements added to the buffer. </returns>
     virtual size_t fetch(size_t n);
 
+    /// Sets the index of the tokens from {@code first} on, which were just added by the token source, and converts
+    /// them to compact tokens if enabled. Returns the number of these tokens.
+    size_t addFetchedTokens(size_t first);
+
     virtual Token* LB(size_t k);
 
     /// Allowed derived classes to modify the behavior of operations which change
@@ -9,3 +9,11 @@ using namespace antlr4;
 
 CharStream::~CharStream() {
 }
+
+bool CharStream::getTextView(const misc::Interval &/*interval*/, antlrcpp::StringView &/*text*/) {
+  return false;
+}
+
+const LineIndex* CharStream::getLineIndex() {
+  return nullptr;
+}
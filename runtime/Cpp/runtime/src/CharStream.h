@@ -7,6 +7,7 @@
 
 #include "IntStream.h"
 #include "misc/Interval.h"
+#include "support/StringView.h"
 
 namespace antlr4 {
 
@@ -31,7 +32,17 @@ namespace antlr4 {
     /// getting the text of the specified interval </exception>
     virtual std::string getText(const misc::Interval &interval) = 0;
 
+    /// Like getText(), but stores a view of the text in {@code text} instead of copying it, if the stream keeps the
+    /// text of the interval as UTF-8 (or ASCII) in a buffer of its own, and returns true. The view stays valid until
+    /// the content of the stream changes. Returns false, which is the default, if the text has to be converted.
+    virtual bool getTextView(const misc::Interval &interval, antlrcpp::StringView &text);
+
     virtual std::string toString() const = 0;
+
+    /// Returns the line index of the whole input, building it on the first call, or nullptr if the stream cannot
+    /// provide one (which is the default), e.g. because it does not keep the whole input. The index stays valid
+    /// until the content of the stream changes.
+    virtual const LineIndex* getLineIndex();
   };
 
 } // namespace antlr4
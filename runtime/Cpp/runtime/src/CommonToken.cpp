@@ -92,6 +92,26 @@ std::string CommonToken::getText() const {
   }
 }
 
+bool CommonToken::getTextView(antlrcpp::StringView &text) const {
+  if (!_text.empty()) {
+    text = _text;
+    return true;
+  }
+
+  CharStream *input = getInputStream();
+  if (input == nullptr) {
+    text = "";
+    return true;
+  }
+  size_t n = input->size();
+  if (_start < n && _stop < n) {
+    return input->getTextView(misc::Interval(_start, _stop), text);
+  } else {
+    text = "<EOF>";
+    return true;
+  }
+}
+
 void CommonToken::setText(const std::string &text) {
   _text = text;
 }
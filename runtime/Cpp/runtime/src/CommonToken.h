@@ -10,6 +10,8 @@
 namespace antlr4 {
 
   class ANTLR4CPP_PUBLIC CommonToken : public WritableToken {
+    friend class TokenStore;
+
   protected:
     /**
      * An empty {@link Pair} which is used as the default value of
@@ -124,6 +126,7 @@ namespace antlr4 {
      */
     virtual void setText(const std::string &text) override;
     virtual std::string getText() const override;
+    virtual bool getTextView(antlrcpp::StringView &text) const override;
 
     virtual void setLine(size_t line) override;
     virtual size_t getLine() const override;
@@ -19,6 +19,10 @@ CommonTokenFactory::CommonTokenFactory(bool copyText_) : copyText(copyText_) {
 CommonTokenFactory::CommonTokenFactory() : CommonTokenFactory(false) {
 }
 
+bool CommonTokenFactory::copiesText() const {
+  return copyText;
+}
+
 std::unique_ptr<CommonToken> CommonTokenFactory::create(std::pair<TokenSource*, CharStream*> source, size_t type,
   const std::string &text, size_t channel, size_t start, size_t stop, size_t line, size_t charPositionInLine) {
 
@@ -65,6 +65,9 @@ namespace antlr4 {
      */
     CommonTokenFactory();
 
+    /// Returns whether this factory sets the text of the tokens it creates (see {@link #copyText}).
+    bool copiesText() const;
+
     virtual std::unique_ptr<CommonToken> create(std::pair<TokenSource*, CharStream*> source, size_t type,
       const std::string &text, size_t channel, size_t start, size_t stop, size_t line, size_t charPositionInLine) override;
 
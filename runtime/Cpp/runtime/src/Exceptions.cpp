@@ -62,3 +62,8 @@ CancellationException::~CancellationException() {
 
 ParseCancellationException::~ParseCancellationException() {
 }
+
+//------------------ IncompleteInputException --------------------------------------------------------------------------
+
+IncompleteInputException::~IncompleteInputException() {
+}
@@ -96,4 +96,13 @@ namespace antlr4 {
     ParseCancellationException& operator=(ParseCancellationException const&) = default;
   };
 
+  /// Thrown by a char stream which is not at its end, but has no more input buffered yet (see PushCharStream).
+  class ANTLR4CPP_PUBLIC IncompleteInputException : public IllegalStateException {
+  public:
+    IncompleteInputException(const std::string &msg = "") : IllegalStateException(msg) {}
+    IncompleteInputException(IncompleteInputException const&) = default;
+    ~IncompleteInputException();
+    IncompleteInputException& operator=(IncompleteInputException const&) = default;
+  };
+
 } // namespace antlr4
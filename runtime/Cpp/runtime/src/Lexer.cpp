@@ -11,6 +11,7 @@
 #include "ANTLRErrorListener.h"
 #include "support/CPPUtils.h"
 #include "CommonToken.h"
+#include "LineIndex.h"
 #include "support/StringUtils.h"
 
 #include "Lexer.h"
@@ -44,6 +45,7 @@ void Lexer::reset() {
   _text = "";
 
   hitEOF = false;
+  _matchSuspended = false;
   mode = Lexer::DEFAULT_MODE;
   modeStack.clear();
 
@@ -54,6 +56,9 @@ std::unique_ptr<Token> Lexer::nextToken() {
   // Mark start location in char stream so unbuffered streams are
   // guaranteed at least have text of current token
   ssize_t tokenStartMarker = _input->mark();
+  atn::LexerATNSimulator *interpreter = getInterpreter<atn::LexerATNSimulator>();
+  const LineIndex *lineIndex = getUsedLineIndex();
+  interpreter->setLineCounting(lineIndex == nullptr);
 
   auto onExit = finally([this, tokenStartMarker]{
     // make sure we release marker after match or
@@ -61,6 +66,36 @@ std::unique_ptr<Token> Lexer::nextToken() {
     _input->release(tokenStartMarker);
   });
 
+  return matchToken(interpreter, lineIndex);
+}
+
+size_t Lexer::nextTokens(std::vector<std::unique_ptr<Token>> &tokens, size_t maxCount) {
+  if (!_tokenBatchingEnabled) {
+    return TokenSource::nextTokens(tokens, maxCount);
+  }
+
+  // One mark for the whole batch keeps the text of all its tokens in unbuffered streams.
+  ssize_t batchStartMarker = _input->mark();
+  atn::LexerATNSimulator *interpreter = getInterpreter<atn::LexerATNSimulator>();
+  const LineIndex *lineIndex = getUsedLineIndex();
+  interpreter->setLineCounting(lineIndex == nullptr);
+
+  auto onExit = finally([this, batchStartMarker]{
+    _input->release(batchStartMarker);
+  });
+
+  size_t count = 0;
+  while (count < maxCount) {
+    tokens.push_back(matchToken(interpreter, lineIndex));
+    ++count;
+    if (tokens.back()->getType() == Token::EOF) {
+      break;
+    }
+  }
+  return count;
+}
+
+std::unique_ptr<Token> Lexer::matchToken(atn::LexerATNSimulator *interpreter, const LineIndex *lineIndex) {
   while (true) {
   outerContinue:
     if (hitEOF) {
@@ -68,21 +103,42 @@ std::unique_ptr<Token> Lexer::nextToken() {
       return std::move(token);
     }
 
-    token.reset();
-    channel = Token::DEFAULT_CHANNEL;
-    tokenStartCharIndex = _input->index();
-    tokenStartCharPositionInLine = getInterpreter<atn::LexerATNSimulator>()->getCharPositionInLine();
-    tokenStartLine = getInterpreter<atn::LexerATNSimulator>()->getLine();
-    _text = "";
+    if (_matchSuspended) {
+      // Continue the token for which the input ran out in the last call.
+      _matchSuspended = false;
+    } else {
+      token.reset();
+      channel = Token::DEFAULT_CHANNEL;
+      tokenStartCharIndex = _input->index();
+      if (lineIndex != nullptr) {
+        tokenStartLine = getIndexedLine(lineIndex, tokenStartCharIndex);
+        tokenStartCharPositionInLine = tokenStartCharIndex - lineIndex->getLineStart(tokenStartLine);
+      } else {
+        tokenStartCharPositionInLine = interpreter->getCharPositionInLine();
+        tokenStartLine = interpreter->getLine();
+      }
+      _text = "";
+    }
     do {
       type = Token::INVALID_TYPE;
       size_t ttype;
+      size_t matchStartIndex = _input->index();
+      size_t matchStartLine = interpreter->getLine();
+      size_t matchStartCharPositionInLine = interpreter->getCharPositionInLine();
       try {
-        ttype = getInterpreter<atn::LexerATNSimulator>()->match(_input, mode);
+        ttype = interpreter->match(_input, mode);
       } catch (LexerNoViableAltException &e) {
         notifyListeners(e); // report error
         recover(e);
         ttype = SKIP;
+      } catch (IncompleteInputException &) {
+        // The char stream has to wait for more input. No lexer action ran yet for this match, so go back to
+        // where it started and try it again on the next call.
+        _input->seek(matchStartIndex);
+        interpreter->setLine(matchStartLine);
+        interpreter->setCharPositionInLine(matchStartCharPositionInLine);
+        _matchSuspended = true;
+        throw;
       }
       if (_input->LA(1) == EOF) {
         hitEOF = true;
@@ -171,10 +227,18 @@ Token* Lexer::emitEOF() {
 }
 
 size_t Lexer::getLine() const {
+  const LineIndex *lineIndex = getUsedLineIndex();
+  if (lineIndex != nullptr) {
+    return getIndexedLine(lineIndex, _input->index());
+  }
   return getInterpreter<atn::LexerATNSimulator>()->getLine();
 }
 
 size_t Lexer::getCharPositionInLine() {
+  const LineIndex *lineIndex = getUsedLineIndex();
+  if (lineIndex != nullptr) {
+    return getIndexedCharPositionInLine(lineIndex, _input->index());
+  }
   return getInterpreter<atn::LexerATNSimulator>()->getCharPositionInLine();
 }
 
@@ -186,6 +250,47 @@ void Lexer::setCharPositionInLine(size_t charPositionInLine) {
   getInterpreter<atn::LexerATNSimulator>()->setCharPositionInLine(charPositionInLine);
 }
 
+void Lexer::setLineIndexEnabled(bool enabled) {
+  if (!enabled && _lineIndexEnabled) {
+    // Continue counting from the current position.
+    size_t line = getLine();
+    size_t charPositionInLine = getCharPositionInLine();
+    _lineIndexEnabled = false;
+    getInterpreter<atn::LexerATNSimulator>()->setLineCounting(true);
+    setLine(line);
+    setCharPositionInLine(charPositionInLine);
+  }
+  _lineIndexEnabled = enabled;
+}
+
+bool Lexer::isLineIndexEnabled() const {
+  return _lineIndexEnabled;
+}
+
+void Lexer::setTokenBatchingEnabled(bool enabled) {
+  _tokenBatchingEnabled = enabled;
+}
+
+bool Lexer::isTokenBatchingEnabled() const {
+  return _tokenBatchingEnabled;
+}
+
+const LineIndex* Lexer::getUsedLineIndex() const {
+  if (!_lineIndexEnabled || _input == nullptr) {
+    return nullptr;
+  }
+  return _input->getLineIndex();
+}
+
+size_t Lexer::getIndexedLine(const LineIndex *lineIndex, size_t index) const {
+  _lineHint = lineIndex->getLine(index, _lineHint);
+  return _lineHint;
+}
+
+size_t Lexer::getIndexedCharPositionInLine(const LineIndex *lineIndex, size_t index) const {
+  return index - lineIndex->getLineStart(getIndexedLine(lineIndex, index));
+}
+
 size_t Lexer::getCharIndex() {
   return _input->index();
 }
@@ -289,6 +394,10 @@ void Lexer::InitializeInstanceFields() {
   tokenStartLine = 0;
   tokenStartCharPositionInLine = 0;
   hitEOF = false;
+  _matchSuspended = false;
+  _lineIndexEnabled = false;
+  _tokenBatchingEnabled = false;
+  _lineHint = 1;
   channel = 0;
   type = 0;
   mode = Lexer::DEFAULT_MODE;
@@ -95,8 +95,15 @@ namespace antlr4 {
     virtual void reset();
 
     /// Return a token from this source; i.e., match a token on the char stream.
+    /// If the char stream throws an IncompleteInputException (see PushCharStream), the exception is passed on and
+    /// the next call continues with the same token.
     virtual std::unique_ptr<Token> nextToken() override;
 
+    /// If token batching is enabled, matches the tokens in one loop which does not call nextToken() and marks the
+    /// input, looks up the ATN simulator and the line index once per batch instead of once per token. Otherwise
+    /// nextToken() is called for each token, like in TokenSource::nextTokens().
+    virtual size_t nextTokens(std::vector<std::unique_ptr<Token>> &tokens, size_t maxCount) override;
+
     /// Instruct the lexer to skip creating a token for current lexer rule
     /// and look for another token.  nextToken() knows to keep looking when
     /// a lexer rule finishes with token set to SKIP_TOKEN.  Recall that
@@ -145,6 +152,18 @@ namespace antlr4 {
 
     virtual void setCharPositionInLine(size_t charPositionInLine);
 
+    /// Takes lines and columns from the line index of the input (see CharStream::getLineIndex()) instead of counting
+    /// them for every consumed character. Inputs without a line index are still counted. While this is on,
+    /// setLine() and setCharPositionInLine() have no effect.
+    virtual void setLineIndexEnabled(bool enabled);
+    bool isLineIndexEnabled() const;
+
+    /// Lets nextTokens() match tokens without calling nextToken() for each of them. Only enable this for lexers which
+    /// do not override nextToken(), because the override would be bypassed. emit() and the other hooks are still
+    /// called. Off by default.
+    virtual void setTokenBatchingEnabled(bool enabled);
+    bool isTokenBatchingEnabled() const;
+
     /// What is the index of the current character of lookahead?
     virtual size_t getCharIndex();
 
@@ -203,6 +222,26 @@ namespace antlr4 {
 
   private:
     size_t _syntaxErrors;
+
+    /// Set when the last nextToken() call ran out of input in the middle of a token.
+    bool _matchSuspended;
+
+    bool _lineIndexEnabled;
+    bool _tokenBatchingEnabled;
+
+    /// The line of the last line index lookup. Tokens come in input order, so it is usually the next line looked up.
+    mutable size_t _lineHint;
+
+    /// The line index of the input if it is used for lines and columns, otherwise nullptr.
+    const LineIndex* getUsedLineIndex() const;
+
+    /// The part of nextToken() which runs for every token. The caller marks the input.
+    std::unique_ptr<Token> matchToken(atn::LexerATNSimulator *interpreter, const LineIndex *lineIndex);
+
+    /// Looks up the line and column of a character index in the line index.
+    size_t getIndexedLine(const LineIndex *lineIndex, size_t index) const;
+    size_t getIndexedCharPositionInLine(const LineIndex *lineIndex, size_t index) const;
+
     void InitializeInstanceFields();
   };
 
@@ -0,0 +1,166 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#include "Exceptions.h"
+
+#include "LineIndex.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+  #define ANTLR4_LINEINDEX_X64
+  #include <emmintrin.h>
+#endif
+
+using namespace antlr4;
+
+namespace {
+
+#ifdef ANTLR4_LINEINDEX_X64
+
+  inline size_t countTrailingZeros(uint32_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return index;
+#else
+    return static_cast<size_t>(__builtin_ctz(value));
+#endif
+  }
+
+  // Adds the line starts for the newlines in a 16 byte block, given the movemask of the comparison with '\n'.
+  inline void addLineStarts(uint32_t mask, size_t unitSize, size_t index, std::vector<size_t> &lineStarts) {
+    while (mask != 0) {
+      size_t bit = countTrailingZeros(mask);
+      lineStarts.push_back(index + bit / unitSize + 1);
+      mask &= ~(((1U << unitSize) - 1) << bit);
+    }
+  }
+
+  size_t findNewlines(const char16_t *data, size_t size, std::vector<size_t> &lineStarts) {
+    const __m128i newline = _mm_set1_epi16('\n');
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+      uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi16(block, newline)));
+      addLineStarts(mask, 2, i, lineStarts);
+    }
+    return i;
+  }
+
+  size_t findNewlines(const char32_t *data, size_t size, std::vector<size_t> &lineStarts) {
+    const __m128i newline = _mm_set1_epi32('\n');
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+      uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi32(block, newline)));
+      addLineStarts(mask, 4, i, lineStarts);
+    }
+    return i;
+  }
+
+#else
+
+  template <typename T>
+  size_t findNewlines(const T * /*data*/, size_t /*size*/, std::vector<size_t> & /*lineStarts*/) {
+    return 0;
+  }
+
+#endif
+
+  template <typename T>
+  void findAllNewlines(const T *data, size_t size, std::vector<size_t> &lineStarts) {
+    for (size_t i = findNewlines(data, size, lineStarts); i < size; ++i) {
+      if (data[i] == '\n') {
+        lineStarts.push_back(i + 1);
+      }
+    }
+  }
+
+  // Counts the code points in UTF-8 text, i.e. the bytes which are no continuation bytes.
+  size_t countCodePoints(const char *first, const char *last) {
+    size_t count = 0;
+    for (; first != last; ++first) {
+      count += (static_cast<unsigned char>(*first) & 0xC0) != 0x80 ? 1 : 0;
+    }
+    return count;
+  }
+
+}
+
+LineIndex::LineIndex() {
+  _lineStarts.push_back(0);
+}
+
+LineIndex::LineIndex(const unsigned char *data, size_t size) : LineIndex() {
+  // memchr is vectorized by the C library.
+  const unsigned char *end = data + size;
+  for (const unsigned char *p = data; p != end;) {
+    const void *newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    if (newline == nullptr) {
+      break;
+    }
+    p = static_cast<const unsigned char *>(newline) + 1;
+    _lineStarts.push_back(static_cast<size_t>(p - data));
+  }
+}
+
+LineIndex::LineIndex(const char16_t *data, size_t size) : LineIndex() {
+  findAllNewlines(data, size, _lineStarts);
+}
+
+LineIndex::LineIndex(const char32_t *data, size_t size) : LineIndex() {
+  findAllNewlines(data, size, _lineStarts);
+}
+
+LineIndex LineIndex::fromUtf8(const char *data, size_t size) {
+  LineIndex result;
+  const char *end = data + size;
+  const char *lineStart = data;
+  size_t index = 0;
+  for (const char *p = data; p != end;) {
+    const void *newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    if (newline == nullptr) {
+      break;
+    }
+    p = static_cast<const char *>(newline) + 1;
+    index += countCodePoints(lineStart, p);
+    lineStart = p;
+    result._lineStarts.push_back(index);
+  }
+  return result;
+}
+
+size_t LineIndex::getLine(size_t index) const {
+  // The number of lines which start at or before the index.
+  return static_cast<size_t>(std::upper_bound(_lineStarts.begin(), _lineStarts.end(), index) - _lineStarts.begin());
+}
+
+size_t LineIndex::getLine(size_t index, size_t hint) const {
+  if (hint > 0 && hint <= _lineStarts.size() && _lineStarts[hint - 1] <= index) {
+    for (size_t line = hint; line <= hint + 1 && line <= _lineStarts.size(); ++line) {
+      if (line == _lineStarts.size() || index < _lineStarts[line]) {
+        return line;
+      }
+    }
+  }
+  return getLine(index);
+}
+
+size_t LineIndex::getCharPositionInLine(size_t index) const {
+  return index - _lineStarts[getLine(index) - 1];
+}
+
+size_t LineIndex::getLineStart(size_t line) const {
+  if (line == 0 || line > _lineStarts.size()) {
+    throw IndexOutOfBoundsException("line " + std::to_string(line) + " is not in 1.." +
+      std::to_string(_lineStarts.size()));
+  }
+  return _lineStarts[line - 1];
+}
+
+size_t LineIndex::getLineCount() const {
+  return _lineStarts.size();
+}
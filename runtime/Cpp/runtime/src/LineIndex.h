@@ -0,0 +1,50 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#pragma once
+
+#include "antlr4-common.h"
+
+namespace antlr4 {
+
+  /// The start indexes of all lines of a text, to map character indexes to lines and columns with a binary search.
+  /// Char streams which have their whole input build it on request (see CharStream::getLineIndex()), a lexer can
+  /// then take the positions of its tokens from it instead of counting lines for every character it consumes.
+  ///
+  /// As in the lexer, lines are separated by '\n', the first line is 1 and the first column is 0. The newlines are
+  /// searched 16 bytes at a time with SSE2 on x86-64.
+  class ANTLR4CPP_PUBLIC LineIndex {
+  public:
+    /// Indexes text with one code unit per character: Latin-1, UCS-2 or UTF-32.
+    LineIndex(const unsigned char *data, size_t size);
+    LineIndex(const char16_t *data, size_t size);
+    LineIndex(const char32_t *data, size_t size);
+
+    /// Indexes UTF-8 text. Character indexes count code points, the text is not validated.
+    static LineIndex fromUtf8(const char *data, size_t size);
+
+    /// The line of the character at {@code index}. Indexes at or after the end of the text are on the last line.
+    size_t getLine(size_t index) const;
+
+    /// Like getLine(), but tries line {@code hint} and the line after it before searching. With the line of the
+    /// previous lookup as hint, lookups for increasing indexes take constant time.
+    size_t getLine(size_t index, size_t hint) const;
+
+    /// The column of the character at {@code index}, i.e. its distance from the start of its line.
+    size_t getCharPositionInLine(size_t index) const;
+
+    /// The index of the first character of {@code line}.
+    size_t getLineStart(size_t line) const;
+
+    size_t getLineCount() const;
+
+  private:
+    LineIndex();
+
+    /// _lineStarts[i] is the index of the first character of line i + 1.
+    std::vector<size_t> _lineStarts;
+  };
+
+} // namespace antlr4
@@ -0,0 +1,386 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#include "Exceptions.h"
+#include "misc/Interval.h"
+#include "IntStream.h"
+#include "LineIndex.h"
+
+#include "support/StringUtils.h"
+#include "support/Unicode.h"
+
+#include "MappedFileStream.h"
+
+#ifdef _WIN32
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+using namespace antlr4;
+using namespace antlrcpp;
+
+using misc::Interval;
+
+MappedFileStream::MappedFileStream(const std::string &fileName, Encoding encoding)
+  : name(fileName), _fileName(fileName), _encoding(encoding), _data(nullptr), _size(0), _p(0), _position(0),
+    _scannedChars(0), _scannedBytes(0), _asciiPrefix(0), _mapping(nullptr), _mappingSize(0) {
+#ifdef _WIN32
+  _file = INVALID_HANDLE_VALUE;
+  _mappingHandle = nullptr;
+#endif
+
+  map();
+
+  _data = static_cast<const unsigned char *>(_mapping);
+  _size = _mappingSize;
+
+  // Skip the UTF-8 BOM if present.
+  if (_encoding == Encoding::UTF8 && _size >= 3 && _data[0] == 0xEF && _data[1] == 0xBB && _data[2] == 0xBF) {
+    _data += 3;
+    _size -= 3;
+  }
+}
+
+MappedFileStream::~MappedFileStream() {
+  unmap();
+}
+
+void MappedFileStream::reset() {
+  _p = 0;
+  _position = 0;
+}
+
+void MappedFileStream::consume() {
+  if (_position >= _size) {
+    assert(LA(1) == IntStream::EOF);
+    throw IllegalStateException("cannot consume EOF");
+  }
+
+  _position = nextPosition(_position);
+  ++_p;
+}
+
+size_t MappedFileStream::LA(ssize_t i) {
+  if (i == 0) {
+    return 0; // undefined
+  }
+
+  size_t position = _position;
+  if (i > 0) {
+    for (ssize_t n = 1; n < i; ++n) {
+      if (position >= _size) {
+        return IntStream::EOF;
+      }
+      position = nextPosition(position);
+    }
+  } else {
+    if (static_cast<ssize_t>(_p) + i < 0) {
+      return IntStream::EOF; // invalid; no char before first char
+    }
+    for (ssize_t n = 0; n > i; --n) {
+      position = previousPosition(position);
+    }
+  }
+
+  if (position >= _size) {
+    return IntStream::EOF;
+  }
+
+  if (_encoding == Encoding::Latin1 || _data[position] < 0x80) {
+    return _data[position];
+  }
+
+  size_t length;
+  return decode(position, length);
+}
+
+size_t MappedFileStream::index() {
+  return _p;
+}
+
+size_t MappedFileStream::size() {
+  if (_encoding == Encoding::Latin1) {
+    return _size;
+  }
+
+  scanTo(std::numeric_limits<size_t>::max());
+  return _scannedChars;
+}
+
+// Mark/release do nothing. We have the entire file.
+ssize_t MappedFileStream::mark() {
+  return -1;
+}
+
+void MappedFileStream::release(ssize_t /* marker */) {
+}
+
+void MappedFileStream::seek(size_t index) {
+  size_t position = positionOf(index);
+  if (position >= _size) {
+    index = std::min(index, size());
+  }
+
+  _p = index;
+  _position = position;
+}
+
+std::string MappedFileStream::getText(const Interval &interval) {
+  if (interval.a < 0 || interval.b < interval.a) {
+    return "";
+  }
+
+  size_t start = positionOf(static_cast<size_t>(interval.a));
+  if (start >= _size) {
+    return "";
+  }
+  size_t stop = positionOf(static_cast<size_t>(interval.b) + 1);
+
+  if (_encoding == Encoding::UTF8) {
+    return std::string(reinterpret_cast<const char *>(_data) + start, reinterpret_cast<const char *>(_data) + stop);
+  }
+  return encodeUtf8(_data + start, _data + stop);
+}
+
+bool MappedFileStream::getTextView(const Interval &interval, antlrcpp::StringView &text) {
+  if (interval.a < 0 || interval.b < interval.a) {
+    text = StringView();
+    return true;
+  }
+
+  size_t start = positionOf(static_cast<size_t>(interval.a));
+  if (start >= _size) {
+    text = StringView();
+    return true;
+  }
+  size_t stop = positionOf(static_cast<size_t>(interval.b) + 1);
+
+  const char *first = reinterpret_cast<const char *>(_data) + start;
+  if (_encoding == Encoding::Latin1 && asciiPrefixLength(first, first + (stop - start)) != stop - start) {
+    return false;
+  }
+
+  text = StringView(first, stop - start);
+  return true;
+}
+
+std::string MappedFileStream::getSourceName() const {
+  if (name.empty()) {
+    return IntStream::UNKNOWN_SOURCE_NAME;
+  }
+  return name;
+}
+
+std::string MappedFileStream::toString() const {
+  if (_encoding == Encoding::UTF8) {
+    // Validate what was not decoded yet, the content is then returned as is.
+    for (size_t position = _scannedBytes; position < _size;) {
+      position = nextPosition(position);
+    }
+    return std::string(reinterpret_cast<const char *>(_data), _size);
+  }
+  return encodeUtf8(_data, _data + _size);
+}
+
+const LineIndex* MappedFileStream::getLineIndex() {
+  if (_lineIndex == nullptr) {
+    if (_encoding == Encoding::UTF8) {
+      _lineIndex.reset(new LineIndex(LineIndex::fromUtf8(reinterpret_cast<const char *>(_data), _size)));
+    } else {
+      _lineIndex.reset(new LineIndex(_data, _size));
+    }
+  }
+  return _lineIndex.get();
+}
+
+MappedFileStream::Encoding MappedFileStream::getEncoding() const {
+  return _encoding;
+}
+
+size_t MappedFileStream::decode(size_t position, size_t &length) const {
+  uint32_t codePoint = 0;
+  length = decodeUtf8Sequence(_data + position, _size - position, codePoint);
+  if (length == 0) {
+    size_t offset = position + static_cast<size_t>(_data - static_cast<const unsigned char *>(_mapping));
+    throw IllegalArgumentException("Invalid UTF-8 sequence at byte " + std::to_string(offset) + " of " + _fileName);
+  }
+
+  return codePoint;
+}
+
+size_t MappedFileStream::nextPosition(size_t position) const {
+  if (_encoding == Encoding::Latin1 || _data[position] < 0x80) {
+    return position + 1;
+  }
+
+  size_t length;
+  decode(position, length);
+  return position + length;
+}
+
+size_t MappedFileStream::previousPosition(size_t position) const {
+  if (_encoding == Encoding::Latin1) {
+    return position - 1;
+  }
+
+  // The content before the position has been decoded already, so it is valid UTF-8 and the previous
+  // character starts at the first byte which is not a continuation byte.
+  do {
+    --position;
+  } while (position > 0 && (_data[position] & 0xC0) == 0x80);
+  return position;
+}
+
+size_t MappedFileStream::positionOf(size_t index) {
+  if (_encoding == Encoding::Latin1) {
+    return std::min(index, _size);
+  }
+
+  if (index == _p) {
+    return _position;
+  }
+
+  if (index <= _asciiPrefix) {
+    return index;
+  }
+
+  // Lexers mostly seek back a few characters, to the start of a token. Walking back from the current position
+  // is cheaper than going forward from a checkpoint then.
+  if (index < _p && _p - index < CHECKPOINT_INTERVAL) {
+    size_t position = _position;
+    for (size_t i = index; i < _p; ++i) {
+      position = previousPosition(position);
+    }
+    return position;
+  }
+
+  scanTo(index);
+  if (index >= _scannedChars) {
+    return _scannedBytes;
+  }
+
+  size_t checkpoint = (index - _asciiPrefix) / CHECKPOINT_INTERVAL;
+  size_t position = _checkpoints[checkpoint];
+  for (size_t i = _asciiPrefix + checkpoint * CHECKPOINT_INTERVAL; i < index; ++i) {
+    position = nextPosition(position);
+  }
+  return position;
+}
+
+void MappedFileStream::scanTo(size_t index) {
+  while (_scannedChars < index && _scannedBytes < _size) {
+    if (_asciiPrefix == _scannedBytes) {
+      // Still in the pure ASCII part, where character indexes and byte offsets are the same.
+      const char *first = reinterpret_cast<const char *>(_data) + _scannedBytes;
+      size_t run = asciiPrefixLength(first, first + std::min(index - _scannedChars, _size - _scannedBytes));
+      if (run > 0) {
+        _scannedBytes += run;
+        _scannedChars += run;
+        _asciiPrefix += run;
+        continue;
+      }
+    }
+
+    if ((_scannedChars - _asciiPrefix) % CHECKPOINT_INTERVAL == 0) {
+      _checkpoints.push_back(_scannedBytes);
+    }
+    _scannedBytes = nextPosition(_scannedBytes);
+    ++_scannedChars;
+  }
+}
+
+#ifdef _WIN32
+
+void MappedFileStream::map() {
+  HANDLE file = CreateFileW(s2ws(_fileName).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    throw IOException("Cannot open file " + _fileName);
+  }
+  _file = file;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    unmap();
+    throw IOException("Cannot determine the size of file " + _fileName);
+  }
+  if (size.QuadPart == 0) {
+    return; // Empty files cannot be mapped.
+  }
+
+  _mappingHandle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (_mappingHandle != nullptr) {
+    _mapping = MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+  }
+  if (_mapping == nullptr) {
+    unmap();
+    throw IOException("Cannot map file " + _fileName);
+  }
+  _mappingSize = static_cast<size_t>(size.QuadPart);
+}
+
+void MappedFileStream::unmap() {
+  if (_mapping != nullptr) {
+    UnmapViewOfFile(_mapping);
+    _mapping = nullptr;
+  }
+  if (_mappingHandle != nullptr) {
+    CloseHandle(_mappingHandle);
+    _mappingHandle = nullptr;
+  }
+  if (_file != INVALID_HANDLE_VALUE) {
+    CloseHandle(_file);
+    _file = INVALID_HANDLE_VALUE;
+  }
+}
+
+#else
+
+void MappedFileStream::map() {
+  int fd = open(_fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw IOException("Cannot open file " + _fileName);
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    throw IOException("Cannot determine the size of file " + _fileName);
+  }
+  if (info.st_size == 0) {
+    close(fd);
+    return; // Empty files cannot be mapped.
+  }
+
+  void *mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // The mapping stays valid without the descriptor.
+  if (mapping == MAP_FAILED) {
+    throw IOException("Cannot map file " + _fileName);
+  }
+
+#ifdef MADV_SEQUENTIAL
+  // Lexers read from front to back, let the kernel read ahead aggressively.
+  madvise(mapping, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+#endif
+
+  _mapping = mapping;
+  _mappingSize = static_cast<size_t>(info.st_size);
+}
+
+void MappedFileStream::unmap() {
+  if (_mapping != nullptr) {
+    munmap(_mapping, _mappingSize);
+    _mapping = nullptr;
+  }
+}
+
+#endif
@@ -0,0 +1,126 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#pragma once
+
+#include "CharStream.h"
+
+namespace antlr4 {
+
+  /// A char stream which maps a file into memory and reads the characters directly from the mapped bytes,
+  /// instead of loading the whole file and converting it to UTF-32 first like ANTLRFileStream does. Only the
+  /// parts of the file that are actually read are paged in, and no copy of the content is made.
+  ///
+  /// Latin-1 files are indexed directly. UTF-8 files are decoded lazily: as long as the content is pure ASCII
+  /// a character index is also the byte offset, after the first non-ASCII character the stream records the byte
+  /// offset of every CHECKPOINT_INTERVAL-th character it has passed, to find the byte offset for seek() and
+  /// getText(). Invalid UTF-8 is reported with an IllegalArgumentException when it is reached.
+  ///
+  /// The file must not be modified while the stream exists.
+  class ANTLR4CPP_PUBLIC MappedFileStream : public CharStream {
+  public:
+    enum class Encoding {
+      UTF8,
+      Latin1
+    };
+
+#if __cplusplus >= 201703L
+    static constexpr size_t CHECKPOINT_INTERVAL = 256;
+#else
+    enum : size_t {
+      CHECKPOINT_INTERVAL = 256,
+    };
+#endif
+
+    /// The name or source of this char stream, defaults to the file name.
+    std::string name;
+
+    /// Maps the given file (name encoded in UTF-8). A UTF-8 BOM at the start of a UTF-8 file is skipped.
+    /// @throws IOException if the file cannot be opened or mapped.
+    MappedFileStream(const std::string &fileName, Encoding encoding = Encoding::UTF8);
+    MappedFileStream(const MappedFileStream &) = delete;
+    virtual ~MappedFileStream();
+
+    MappedFileStream& operator = (const MappedFileStream &) = delete;
+
+    /// Reset the stream to the first character.
+    virtual void reset();
+    virtual void consume() override;
+    virtual size_t LA(ssize_t i) override;
+
+    virtual size_t index() override;
+
+    /// For UTF-8 files this has to decode the rest of the file the first time it is called.
+    virtual size_t size() override;
+
+    /// mark/release do nothing; we have the entire file.
+    virtual ssize_t mark() override;
+    virtual void release(ssize_t marker) override;
+
+    virtual void seek(size_t index) override;
+    virtual std::string getText(const misc::Interval &interval) override;
+
+    /// Views into the mapped file are available for all text of a UTF-8 file and for the ASCII parts of a Latin-1
+    /// file.
+    virtual bool getTextView(const misc::Interval &interval, antlrcpp::StringView &text) override;
+    virtual std::string getSourceName() const override;
+    virtual std::string toString() const override;
+    virtual const LineIndex* getLineIndex() override;
+
+    Encoding getEncoding() const;
+
+  protected:
+    std::string _fileName; // UTF-8 encoded file name.
+    Encoding _encoding;
+
+    /// The content (after the BOM, if any) and its size in bytes.
+    const unsigned char *_data;
+    size_t _size;
+
+    /// Index of the next character and the byte offset where it starts.
+    size_t _p;
+    size_t _position;
+
+    /// The part of a UTF-8 file for which character indexes can be mapped to byte offsets: _scannedChars characters
+    /// in _scannedBytes bytes. The first _asciiPrefix bytes are ASCII. For the rest, _checkpoints holds the byte
+    /// offset of character _asciiPrefix + n * CHECKPOINT_INTERVAL at position n.
+    size_t _scannedChars;
+    size_t _scannedBytes;
+    size_t _asciiPrefix;
+    std::vector<size_t> _checkpoints;
+
+    /// Built by getLineIndex().
+    std::unique_ptr<LineIndex> _lineIndex;
+
+    /// Decodes the UTF-8 character starting at byte offset {@code position} (which must be less than _size) and
+    /// stores its length in bytes in {@code length}.
+    size_t decode(size_t position, size_t &length) const;
+
+    /// Returns the byte offset of the character following the one at {@code position}.
+    size_t nextPosition(size_t position) const;
+
+    /// Returns the byte offset of the character preceding the one at {@code position}. Only valid for positions
+    /// behind content that was already decoded.
+    size_t previousPosition(size_t position) const;
+
+    /// Returns the byte offset of the character with the given index, or _size if the index is at or past the end.
+    size_t positionOf(size_t index);
+
+    /// Extends the scanned part of a UTF-8 file until it covers {@code index} characters or the whole file.
+    void scanTo(size_t index);
+
+  private:
+    void *_mapping;
+    size_t _mappingSize;
+#ifdef _WIN32
+    void *_file;
+    void *_mappingHandle;
+#endif
+
+    void map();
+    void unmap();
+  };
+
+} // namespace antlr4
@@ -0,0 +1,347 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#include "ANTLRInputStream.h"
+#include "BaseErrorListener.h"
+#include "CommonToken.h"
+#include "CommonTokenFactory.h"
+#include "ConsoleErrorListener.h"
+#include "Lexer.h"
+#include "misc/Interval.h"
+
+#include "ParallelTokenSource.h"
+
+#include <thread>
+
+using namespace antlr4;
+using namespace antlr4::misc;
+
+namespace {
+
+  // Creates the tokens of a chunk lexer for the whole input: indexes are moved by the start of the chunk and the
+  // tokens refer to the parallel token source and the original input. Lines and columns are corrected later, when the
+  // chunks before are lexed.
+  //
+  // The original input must not be read without the input lock, so a factory which copies the token text gets it
+  // from the chunk's own stream instead. Factories other than CommonTokenFactory are assumed to copy the text.
+  class ChunkTokenFactory : public TokenFactory<CommonToken> {
+  public:
+    ChunkTokenFactory(TokenFactory<CommonToken> *factory, std::pair<TokenSource *, CharStream *> source,
+      CharStream *chunkInput, size_t offset, std::mutex &inputLock)
+      : _factory(factory), _source(source), _chunkInput(chunkInput), _offset(offset), _inputLock(inputLock) {
+      CommonTokenFactory *commonFactory = dynamic_cast<CommonTokenFactory *>(factory);
+      _copyText = commonFactory == nullptr || commonFactory->copiesText();
+    }
+
+    virtual std::unique_ptr<CommonToken> create(std::pair<TokenSource*, CharStream*> /*source*/, size_t type,
+      const std::string &text, size_t channel, size_t start, size_t stop, size_t line,
+      size_t charPositionInLine) override {
+      if (!_copyText || !text.empty()) {
+        return _factory->create(_source, type, text, channel, start + _offset, stop + _offset, line,
+          charPositionInLine);
+      }
+
+      std::string chunkText = _chunkInput->getText(Interval(start, stop));
+      if (!chunkText.empty()) {
+        return _factory->create(_source, type, chunkText, channel, start + _offset, stop + _offset, line,
+          charPositionInLine);
+      }
+
+      // Empty tokens (like EOF) have no text to pass on, the factory may then read the original input.
+      std::lock_guard<std::mutex> lock(_inputLock);
+      return _factory->create(_source, type, text, channel, start + _offset, stop + _offset, line, charPositionInLine);
+    }
+
+    virtual std::unique_ptr<CommonToken> create(size_t type, const std::string &text) override {
+      return _factory->create(type, text);
+    }
+
+  private:
+    TokenFactory<CommonToken> *_factory;
+    const std::pair<TokenSource *, CharStream *> _source;
+    CharStream *_chunkInput;
+    const size_t _offset;
+    std::mutex &_inputLock;
+    bool _copyText;
+  };
+
+  struct SyntaxError {
+    Recognizer *recognizer;
+    size_t line;
+    size_t charPositionInLine;
+    std::string msg;
+    std::exception_ptr e;
+  };
+
+  // Keeps the errors of a chunk lexer until they can be reported with the right line and column.
+  class ErrorCollector : public BaseErrorListener {
+  public:
+    std::vector<SyntaxError> errors;
+
+    virtual void syntaxError(Recognizer *recognizer, Token * /*offendingSymbol*/, size_t line,
+      size_t charPositionInLine, const std::string &msg, std::exception_ptr e) override {
+      errors.push_back({ recognizer, line, charPositionInLine, msg, e });
+    }
+  };
+
+}
+
+struct ParallelTokenSource::Chunk {
+  size_t start;
+  size_t stop;
+  bool last;
+
+  std::vector<std::unique_ptr<Token>> tokens;
+
+  // The position at the end of the chunk, relative to its start (the lexer starts at line 1, column 0).
+  size_t endLine;
+  size_t endCharPositionInLine;
+
+  // Kept only if there were errors: their recognizer is the lexer, which refers to its input.
+  std::unique_ptr<ANTLRInputStream> input;
+  std::unique_ptr<Lexer> lexer;
+  ErrorCollector errors;
+
+  std::exception_ptr failure;
+};
+
+ParallelTokenSource::ParallelTokenSource(CharStream *input, LexerFactory createLexer, std::vector<size_t> splitPoints,
+  size_t threadCount)
+  : _input(input), _createLexer(std::move(createLexer)), _splitPoints(std::move(splitPoints)),
+    _threadCount(threadCount), _next(0), _lexed(false), _line(1), _charPositionInLine(0) {
+  if (_threadCount == 0) {
+    _threadCount = std::max(std::thread::hardware_concurrency(), 1U);
+  }
+
+  std::sort(_splitPoints.begin(), _splitPoints.end());
+  _splitPoints.erase(std::unique(_splitPoints.begin(), _splitPoints.end()), _splitPoints.end());
+
+  _listeners.addErrorListener(&ConsoleErrorListener::INSTANCE);
+}
+
+ParallelTokenSource::~ParallelTokenSource() {
+}
+
+std::vector<size_t> ParallelTokenSource::splitAtLines(CharStream *input, size_t chunkSize) {
+  std::vector<size_t> result;
+  size_t index = input->index();
+  size_t size = input->size();
+
+  size_t position = std::max(chunkSize, static_cast<size_t>(1));
+  while (position < size) {
+    input->seek(position - 1);
+    while (input->LA(1) != '\n' && input->LA(1) != IntStream::EOF) {
+      input->consume();
+    }
+    position = input->index() + 1;
+    if (position >= size) {
+      break;
+    }
+    result.push_back(position);
+    position += chunkSize;
+  }
+
+  input->seek(index);
+  return result;
+}
+
+std::unique_ptr<Token> ParallelTokenSource::nextToken() {
+  if (!_lexed) {
+    lex();
+  }
+
+  if (_next < _tokens.size()) {
+    return std::move(_tokens[_next++]);
+  }
+
+  // Like a lexer, keep returning EOF.
+  size_t size = _input->size();
+  return CommonTokenFactory::DEFAULT->create({ this, _input }, Token::EOF, "", Token::DEFAULT_CHANNEL, size, size - 1,
+    _line, _charPositionInLine);
+}
+
+size_t ParallelTokenSource::nextTokens(std::vector<std::unique_ptr<Token>> &tokens, size_t maxCount) {
+  if (!_lexed) {
+    lex();
+  }
+
+  size_t count = std::min(maxCount, _tokens.size() - _next);
+  if (count == 0) {
+    return TokenSource::nextTokens(tokens, maxCount);
+  }
+
+  tokens.insert(tokens.end(), std::make_move_iterator(_tokens.begin() + static_cast<ssize_t>(_next)),
+    std::make_move_iterator(_tokens.begin() + static_cast<ssize_t>(_next + count)));
+  _next += count;
+  return count;
+}
+
+size_t ParallelTokenSource::getLine() const {
+  if (_next < _tokens.size()) {
+    return _tokens[_next]->getLine();
+  }
+  return _line;
+}
+
+size_t ParallelTokenSource::getCharPositionInLine() {
+  if (_next < _tokens.size()) {
+    return _tokens[_next]->getCharPositionInLine();
+  }
+  return _charPositionInLine;
+}
+
+CharStream* ParallelTokenSource::getInputStream() {
+  return _input;
+}
+
+std::string ParallelTokenSource::getSourceName() {
+  return _input->getSourceName();
+}
+
+TokenFactory<CommonToken>* ParallelTokenSource::getTokenFactory() {
+  return CommonTokenFactory::DEFAULT.get();
+}
+
+void ParallelTokenSource::addErrorListener(ANTLRErrorListener *listener) {
+  _listeners.addErrorListener(listener);
+}
+
+void ParallelTokenSource::removeErrorListener(ANTLRErrorListener *listener) {
+  _listeners.removeErrorListener(listener);
+}
+
+void ParallelTokenSource::removeErrorListeners() {
+  _listeners.removeErrorListeners();
+}
+
+void ParallelTokenSource::lex() {
+  _lexed = true;
+
+  size_t size = _input->size();
+  std::vector<Chunk> chunks;
+  size_t start = 0;
+  for (size_t splitPoint : _splitPoints) {
+    if (splitPoint > start && splitPoint < size) {
+      chunks.emplace_back();
+      chunks.back().start = start;
+      chunks.back().stop = splitPoint;
+      chunks.back().last = false;
+      start = splitPoint;
+    }
+  }
+  chunks.emplace_back();
+  chunks.back().start = start;
+  chunks.back().stop = size;
+  chunks.back().last = true;
+
+  // Each thread takes the next chunk which is not lexed yet. The results go to the chunk, so they do not depend on
+  // which thread lexed it.
+  std::mutex inputLock;
+  std::atomic<size_t> nextChunk(0);
+  auto worker = [&]() {
+    for (size_t i = nextChunk++; i < chunks.size(); i = nextChunk++) {
+      try {
+        lexChunk(chunks[i], inputLock);
+      } catch (...) {
+        chunks[i].failure = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  size_t threadCount = std::min(_threadCount, chunks.size());
+  for (size_t i = 1; i < threadCount; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Stitch the chunks together in input order. A chunk lexer starts at line 1, column 0, which is the end position
+  // of the chunk before.
+  size_t count = 0;
+  for (auto &chunk : chunks) {
+    if (chunk.failure) {
+      std::rethrow_exception(chunk.failure);
+    }
+    count += chunk.tokens.size();
+  }
+  _tokens.reserve(count);
+
+  size_t line = 1;
+  size_t charPositionInLine = 0;
+  auto toInput = [&line, &charPositionInLine](size_t &chunkLine, size_t &chunkCharPositionInLine) {
+    if (chunkLine == 1) {
+      chunkCharPositionInLine += charPositionInLine;
+    }
+    chunkLine += line - 1;
+  };
+
+  for (auto &chunk : chunks) {
+    for (auto &token : chunk.tokens) {
+      size_t tokenLine = token->getLine();
+      size_t tokenCharPositionInLine = token->getCharPositionInLine();
+      toInput(tokenLine, tokenCharPositionInLine);
+
+      WritableToken *writable = static_cast<WritableToken *>(token.get());
+      writable->setLine(tokenLine);
+      writable->setCharPositionInLine(tokenCharPositionInLine);
+      _tokens.push_back(std::move(token));
+    }
+
+    for (auto &error : chunk.errors.errors) {
+      toInput(error.line, error.charPositionInLine);
+      _listeners.syntaxError(error.recognizer, nullptr, error.line, error.charPositionInLine, error.msg, error.e);
+    }
+    chunk.lexer.reset();
+    chunk.input.reset();
+
+    toInput(chunk.endLine, chunk.endCharPositionInLine);
+    line = chunk.endLine;
+    charPositionInLine = chunk.endCharPositionInLine;
+  }
+
+  _line = line;
+  _charPositionInLine = charPositionInLine;
+}
+
+void ParallelTokenSource::lexChunk(Chunk &chunk, std::mutex &inputLock) {
+  std::string text;
+  std::string sourceName;
+  {
+    // Char streams keep state even when reading, only one thread at a time may use the input.
+    std::lock_guard<std::mutex> lock(inputLock);
+    if (chunk.stop > chunk.start) {
+      text = _input->getText(Interval(chunk.start, chunk.stop - 1));
+    }
+    sourceName = _input->getSourceName();
+  }
+
+  chunk.input.reset(new ANTLRInputStream(text));
+  chunk.input->name = sourceName;
+  chunk.lexer = _createLexer(chunk.input.get());
+
+  ChunkTokenFactory factory(chunk.lexer->getTokenFactory(), { this, _input }, chunk.input.get(), chunk.start,
+    inputLock);
+  chunk.lexer->setTokenFactory(&factory);
+  chunk.lexer->removeErrorListeners();
+  chunk.lexer->addErrorListener(&chunk.errors);
+
+  while (chunk.tokens.empty() || chunk.tokens.back()->getType() != Token::EOF) {
+    chunk.lexer->nextTokens(chunk.tokens, 1000);
+  }
+  if (!chunk.last) {
+    chunk.tokens.pop_back();
+  }
+  chunk.endLine = chunk.lexer->getLine();
+  chunk.endCharPositionInLine = chunk.lexer->getCharPositionInLine();
+
+  chunk.lexer->setTokenFactory(CommonTokenFactory::DEFAULT.get());
+  if (chunk.errors.errors.empty()) {
+    chunk.lexer.reset();
+    chunk.input.reset();
+  }
+}
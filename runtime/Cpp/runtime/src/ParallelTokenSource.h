@@ -0,0 +1,95 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#pragma once
+
+#include "ProxyErrorListener.h"
+#include "TokenSource.h"
+
+namespace antlr4 {
+
+  /// A token source which lexes its input in chunks, with one lexer per chunk, on several threads. The tokens are the
+  /// same as those of a single lexer for the whole input (with the same start and stop indexes, lines and columns),
+  /// and are returned in input order, so a CommonTokenStream over this source gets the same token indexes too:
+  ///
+  ///   ParallelTokenSource source(&input, [](CharStream *chunk) {
+  ///     return std::unique_ptr<Lexer>(new MyLexer(chunk));
+  ///   }, ParallelTokenSource::splitAtLines(&input, 1 << 20));
+  ///   CommonTokenStream tokens(&source);
+  ///
+  /// This only works if the input is split at safe points: where the lexer of the whole input is in its default mode,
+  /// a token ends and the tokens which follow do not depend on what came before (e.g. between independent records or
+  /// statements), and the tokens before the split point do not depend on what comes after. Which points are safe
+  /// depends on the grammar, so the caller passes them in; splitAtLines() finds line breaks for grammars in which
+  /// every line break is one.
+  ///
+  /// The lexers come from a factory function and get their input as a separate char stream for their chunk. Lexers
+  /// of the same grammar share the DFA cache, so the chunks benefit from each other's DFA states. Token texts are
+  /// taken from the original input (unless the lexer's token factory copies them), which must outlive the tokens.
+  /// The token factory of the lexers is used from several threads, so it must be thread-safe (CommonTokenFactory
+  /// is, PooledTokenFactory is not). Token text it copies is passed to it from the chunk's own stream, as the original
+  /// input is not thread-safe. Only for tokens without text (like EOF) is the factory called under a lock, in case it
+  /// reads the original input.
+  ///
+  /// Lexer errors are collected and reported in input order, with corrected lines and columns, to the error
+  /// listeners of this token source (by default the ConsoleErrorListener, like for a lexer). The recognizer passed
+  /// to the listeners is the lexer of the chunk.
+  class ANTLR4CPP_PUBLIC ParallelTokenSource : public TokenSource {
+  public:
+    typedef std::function<std::unique_ptr<Lexer> (CharStream *input)> LexerFactory;
+
+    /// Lexing starts with the first request for a token. Split points are character indexes at which a new chunk
+    /// starts, {@code threadCount} 0 means one thread per core.
+    ParallelTokenSource(CharStream *input, LexerFactory createLexer, std::vector<size_t> splitPoints,
+      size_t threadCount = 0);
+    ParallelTokenSource(const ParallelTokenSource &) = delete;
+    virtual ~ParallelTokenSource();
+
+    ParallelTokenSource& operator = (const ParallelTokenSource &) = delete;
+
+    /// Returns split points after line breaks, about {@code chunkSize} characters apart. The input is left at its
+    /// current position.
+    static std::vector<size_t> splitAtLines(CharStream *input, size_t chunkSize);
+
+    virtual std::unique_ptr<Token> nextToken() override;
+    virtual size_t nextTokens(std::vector<std::unique_ptr<Token>> &tokens, size_t maxCount) override;
+
+    /// The line and column of the next token, or of the end of the input.
+    virtual size_t getLine() const override;
+    virtual size_t getCharPositionInLine() override;
+
+    virtual CharStream* getInputStream() override;
+    virtual std::string getSourceName() override;
+    virtual TokenFactory<CommonToken>* getTokenFactory() override;
+
+    void addErrorListener(ANTLRErrorListener *listener);
+    void removeErrorListener(ANTLRErrorListener *listener);
+    void removeErrorListeners();
+
+  protected:
+    struct Chunk;
+
+    CharStream *_input;
+    LexerFactory _createLexer;
+    std::vector<size_t> _splitPoints;
+    size_t _threadCount;
+
+    /// The tokens of all chunks, _next is the index of the next token to return.
+    std::vector<std::unique_ptr<Token>> _tokens;
+    size_t _next;
+    bool _lexed;
+
+    /// The position at the end of the input, once it was lexed.
+    size_t _line;
+    size_t _charPositionInLine;
+
+    ProxyErrorListener _listeners;
+
+    /// Lexes all chunks and stitches their tokens together.
+    void lex();
+    void lexChunk(Chunk &chunk, std::mutex &inputLock);
+  };
+
+} // namespace antlr4
@@ -164,6 +164,14 @@ bool Parser::getTrimParseTree() {
   return std::find(getParseListeners().begin(), getParseListeners().end(), &TrimToSizeListener::INSTANCE) != getParseListeners().end();
 }
 
+void Parser::setChildIndexThreshold(size_t threshold) {
+  _childIndexThreshold = threshold;
+}
+
+size_t Parser::getChildIndexThreshold() const {
+  return _childIndexThreshold;
+}
+
 std::vector<tree::ParseTreeListener *> Parser::getParseListeners() {
   return _parseListeners;
 }
@@ -352,6 +360,10 @@ void Parser::exitRule() {
     _ctx->stop = _input->LT(-1); // stop node is what we just matched
   }
 
+  if (_childIndexThreshold > 0 && _ctx->children.size() >= _childIndexThreshold) {
+    _ctx->buildChildIndex();
+  }
+
   // trigger event on ctx, before it reverts to parent
   if (_parseListeners.size() > 0) {
     triggerExitRuleEvent();
@@ -639,6 +651,7 @@ void Parser::InitializeInstanceFields() {
   _precedenceStack.clear();
   _precedenceStack.push_back(0);
   _buildParseTrees = true;
+  _childIndexThreshold = 0;
   _syntaxErrors = 0;
   _matchedEOF = false;
   _input = nullptr;
@@ -125,6 +125,12 @@ namespace antlr4 {
     /// using the default <seealso cref="Parser.TrimToSizeListener"/> during the parse process. </returns>
     virtual bool getTrimParseTree();
 
+    /// Makes the parser build a child index (see ParserRuleContext::buildChildIndex()) for every context which has at
+    /// least {@code threshold} children when its rule is exited, so the generated accessors of wide contexts take
+    /// constant time. 0, the default, disables the index.
+    void setChildIndexThreshold(size_t threshold);
+    size_t getChildIndexThreshold() const;
+
     virtual std::vector<tree::ParseTreeListener *> getParseListeners();
 
     /// <summary>
@@ -428,6 +434,9 @@ namespace antlr4 {
     /// <seealso cref= #setBuildParseTree </seealso>
     bool _buildParseTrees;
 
+    /// The minimum number of children of a context to index them, 0 if no child indexes are built.
+    size_t _childIndexThreshold;
+
     /// The list of <seealso cref="ParseTreeListener"/> listeners registered to receive
     /// events during the parse.
     /// <seealso cref= #addParseListener </seealso>
@@ -18,6 +18,24 @@ using namespace antlr4::tree;
 
 using namespace antlrcpp;
 
+namespace {
+
+  bool isTerminal(ParseTree *tree) {
+    ParseTreeType type = tree->getTreeType();
+    return type == ParseTreeType::TERMINAL || type == ParseTreeType::ERROR;
+  }
+
+}
+
+struct ParserRuleContext::ChildIndex {
+  // The number of children when the index was built, to detect some changes of the children made directly.
+  size_t childCount;
+
+  // The terminal children by token type and the context children by rule index, in order.
+  std::unordered_map<size_t, std::vector<ParseTree *>> tokens;
+  std::unordered_map<size_t, std::vector<ParseTree *>> rules;
+};
+
 ParserRuleContext ParserRuleContext::EMPTY;
 
 ParserRuleContext::ParserRuleContext()
@@ -28,6 +46,9 @@ ParserRuleContext::ParserRuleContext(ParserRuleContext *parent, size_t invokingS
 : RuleContext(parent, invokingStateNumber), start(nullptr), stop(nullptr) {
 }
 
+ParserRuleContext::~ParserRuleContext() {
+}
+
 void ParserRuleContext::copyFrom(ParserRuleContext *ctx) {
   // from RuleContext
   this->parent = ctx->parent;
@@ -39,12 +60,17 @@ void ParserRuleContext::copyFrom(ParserRuleContext *ctx) {
   // copy any error nodes to alt label node
   if (!ctx->children.empty()) {
     for (auto *child : ctx->children) {
+      if (child->getTreeType() != ParseTreeType::ERROR) {
+        continue;
+      }
       auto *errorNode = dynamic_cast<ErrorNode *>(child);
       if (errorNode != nullptr) {
         errorNode->setParent(this);
         children.push_back(errorNode);
       }
     }
+    _childIndex.reset();
+    ctx->_childIndex.reset();
 
     // Remove the just reparented error nodes from the source context.
     ctx->children.erase(std::remove_if(ctx->children.begin(), ctx->children.end(), [this](tree::ParseTree *e) -> bool {
@@ -62,11 +88,13 @@ void ParserRuleContext::exitRule(tree::ParseTreeListener * /*listener*/) {
 tree::TerminalNode* ParserRuleContext::addChild(tree::TerminalNode *t) {
   t->setParent(this);
   children.push_back(t);
+  _childIndex.reset();
   return t;
 }
 
 RuleContext* ParserRuleContext::addChild(RuleContext *ruleInvocation) {
   children.push_back(ruleInvocation);
+  _childIndex.reset();
   return ruleInvocation;
 }
 
@@ -74,6 +102,7 @@ void ParserRuleContext::removeLastChild() {
   if (!children.empty()) {
     children.pop_back();
   }
+  _childIndex.reset();
 }
 
 tree::TerminalNode* ParserRuleContext::getToken(size_t ttype, size_t i) {
@@ -81,10 +110,18 @@ tree::TerminalNode* ParserRuleContext::getToken(size_t ttype, size_t i) {
     return nullptr;
   }
 
+  if (hasChildIndex()) {
+    auto iterator = _childIndex->tokens.find(ttype);
+    if (iterator == _childIndex->tokens.end() || i >= iterator->second.size()) {
+      return nullptr;
+    }
+    return static_cast<tree::TerminalNode *>(iterator->second[i]);
+  }
+
   size_t j = 0; // what token with ttype have we found?
   for (auto *o : children) {
-    if (is<tree::TerminalNode *>(o)) {
-      tree::TerminalNode *tnode = dynamic_cast<tree::TerminalNode *>(o);
+    if (isTerminal(o)) {
+      tree::TerminalNode *tnode = static_cast<tree::TerminalNode *>(o);
       Token *symbol = tnode->getSymbol();
       if (symbol->getType() == ttype) {
         if (j++ == i) {
@@ -100,8 +137,8 @@ tree::TerminalNode* ParserRuleContext::getToken(size_t ttype, size_t i) {
 std::vector<tree::TerminalNode *> ParserRuleContext::getTokens(size_t ttype) {
   std::vector<tree::TerminalNode *> tokens;
   for (auto &o : children) {
-    if (is<tree::TerminalNode *>(o)) {
-      tree::TerminalNode *tnode = dynamic_cast<tree::TerminalNode *>(o);
+    if (isTerminal(o)) {
+      tree::TerminalNode *tnode = static_cast<tree::TerminalNode *>(o);
       Token *symbol = tnode->getSymbol();
       if (symbol->getType() == ttype) {
         tokens.push_back(tnode);
@@ -112,6 +149,53 @@ std::vector<tree::TerminalNode *> ParserRuleContext::getTokens(size_t ttype) {
   return tokens;
 }
 
+void ParserRuleContext::buildChildIndex() {
+  std::unique_ptr<ChildIndex> index(new ChildIndex());
+  index->childCount = children.size();
+  for (auto *child : children) {
+    if (isTerminal(child)) {
+      index->tokens[static_cast<tree::TerminalNode *>(child)->getSymbol()->getType()].push_back(child);
+    } else if (child->getTreeType() == ParseTreeType::RULE) {
+      index->rules[static_cast<RuleContext *>(child)->getRuleIndex()].push_back(child);
+    }
+  }
+  _childIndex = std::move(index);
+}
+
+void ParserRuleContext::dropChildIndex() {
+  _childIndex.reset();
+}
+
+bool ParserRuleContext::hasChildIndex() const {
+  return _childIndex != nullptr && _childIndex->childCount == children.size();
+}
+
+RuleContext* ParserRuleContext::getChildContext(size_t ruleIndex, size_t i) {
+  if (i >= children.size()) {
+    return nullptr;
+  }
+
+  if (hasChildIndex()) {
+    auto iterator = _childIndex->rules.find(ruleIndex);
+    if (iterator == _childIndex->rules.end() || i >= iterator->second.size()) {
+      return nullptr;
+    }
+    return static_cast<RuleContext *>(iterator->second[i]);
+  }
+
+  size_t j = 0;
+  for (auto *child : children) {
+    if (child->getTreeType() == ParseTreeType::RULE) {
+      RuleContext *context = static_cast<RuleContext *>(child);
+      if (context->getRuleIndex() == ruleIndex && j++ == i) {
+        return context;
+      }
+    }
+  }
+
+  return nullptr;
+}
+
 misc::Interval ParserRuleContext::getSourceInterval() {
   if (start == nullptr) {
     return misc::Interval::INVALID;
@@ -67,7 +67,7 @@ namespace antlr4 {
 
     ParserRuleContext();
     ParserRuleContext(ParserRuleContext *parent, size_t invokingStateNumber);
-    virtual ~ParserRuleContext() {}
+    virtual ~ParserRuleContext();
 
     /** COPY a ctx (I'm deliberately not using copy constructor) to avoid
      *  confusion with creating node with parent. Does not copy children
@@ -102,7 +102,7 @@ namespace antlr4 {
 
       size_t j = 0; // what element have we found with ctxType?
       for (auto &child : children) {
-        if (antlrcpp::is<T *>(child)) {
+        if (child->getTreeType() == tree::ParseTreeType::RULE && antlrcpp::is<T *>(child)) {
           if (j++ == i) {
             return dynamic_cast<T *>(child);
           }
@@ -115,7 +115,7 @@ namespace antlr4 {
     std::vector<T *> getRuleContexts() {
       std::vector<T *> contexts;
       for (auto *child : children) {
-        if (antlrcpp::is<T *>(child)) {
+        if (child->getTreeType() == tree::ParseTreeType::RULE && antlrcpp::is<T *>(child)) {
           contexts.push_back(dynamic_cast<T *>(child));
         }
       }
@@ -123,6 +123,36 @@ namespace antlr4 {
       return contexts;
     }
 
+    /// Returns the i-th child context of the rule with the given index, or nullptr. The children are selected by
+    /// comparing rule indexes instead of with dynamic_cast, so all contexts of that rule must be T or derived from T,
+    /// as is the case with the context classes of a generated parser. Generated accessors use this overload.
+    template<typename T>
+    T* getRuleContext(size_t ruleIndex, size_t i) {
+      return static_cast<T *>(getChildContext(ruleIndex, i));
+    }
+
+    /// Returns all child contexts of the rule with the given index, see getRuleContext(size_t, size_t).
+    template<typename T>
+    std::vector<T *> getRuleContexts(size_t ruleIndex) {
+      std::vector<T *> contexts;
+      for (auto *child : children) {
+        if (child->getTreeType() == tree::ParseTreeType::RULE &&
+            static_cast<RuleContext *>(child)->getRuleIndex() == ruleIndex) {
+          contexts.push_back(static_cast<T *>(child));
+        }
+      }
+
+      return contexts;
+    }
+
+    /// Indexes the children by token type and rule index, which makes getToken(ttype, i) and
+    /// getRuleContext<T>(ruleIndex, i) constant time instead of a scan over the children. Worth it for contexts with
+    /// many children, see Parser::setChildIndexThreshold(). addChild() and removeLastChild() drop the index, other
+    /// changes to the children vector must be followed by another call to this method (or to dropChildIndex()).
+    void buildChildIndex();
+    void dropChildIndex();
+    bool hasChildIndex() const;
+
     virtual misc::Interval getSourceInterval() override;
 
     /**
@@ -142,6 +172,13 @@ namespace antlr4 {
     /// <summary>
     /// Used for rule context info debugging during parse-time, not so much for ATN debugging </summary>
     virtual std::string toInfoString(Parser *recognizer);
+
+  private:
+    struct ChildIndex;
+
+    std::unique_ptr<ChildIndex> _childIndex;
+
+    RuleContext* getChildContext(size_t ruleIndex, size_t i);
   };
 
 } // namespace antlr4
@@ -0,0 +1,127 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#include "PooledTokenFactory.h"
+
+using namespace antlr4;
+
+// A token slot. While the slot is free, the memory of the token links the free slots.
+struct PooledTokenFactory::Slot {
+  Pool *pool;
+  union {
+    Slot *next;
+    std::aligned_storage<sizeof(PooledToken), alignof(PooledToken)>::type token;
+  };
+};
+
+struct PooledTokenFactory::Pool {
+  Pool() : references(1), returned(nullptr), free(nullptr), capacity(0) {
+  }
+
+  void release() {
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+  // One for each live token, plus one while the factory exists.
+  std::atomic<size_t> references;
+
+  // Slots of deleted tokens. Tokens may be deleted from any thread, so they are pushed with a CAS. Only the
+  // thread which creates tokens takes them, all at once, so there is no ABA problem.
+  std::atomic<Slot *> returned;
+
+  // Slots ready for new tokens, only used by the thread which creates tokens.
+  Slot *free;
+
+  std::vector<std::unique_ptr<Slot[]>> slabs;
+  size_t capacity;
+};
+
+//----------------- PooledToken ----------------------------------------------------------------------------------------
+
+PooledToken::PooledToken(std::pair<TokenSource *, CharStream *> source, size_t type, size_t channel, size_t start,
+  size_t stop) : CommonToken(source, type, channel, start, stop) {
+}
+
+PooledToken::PooledToken(size_t type, const std::string &text) : CommonToken(type, text) {
+}
+
+void* PooledToken::operator new(size_t /*size*/, void *p) noexcept {
+  return p;
+}
+
+void PooledToken::operator delete(void *p) noexcept {
+  PooledTokenFactory::deallocate(p);
+}
+
+//----------------- PooledTokenFactory ---------------------------------------------------------------------------------
+
+PooledTokenFactory::PooledTokenFactory() : _pool(new Pool()) { /* mem-check: deleted by Pool::release() */
+}
+
+PooledTokenFactory::~PooledTokenFactory() {
+  _pool->release();
+}
+
+std::unique_ptr<CommonToken> PooledTokenFactory::create(std::pair<TokenSource*, CharStream*> source, size_t type,
+  const std::string &text, size_t channel, size_t start, size_t stop, size_t line, size_t charPositionInLine) {
+
+  std::unique_ptr<CommonToken> t(new (allocate()) PooledToken(source, type, channel, start, stop));
+  t->setLine(line);
+  t->setCharPositionInLine(charPositionInLine);
+  if (text != "") {
+    t->setText(text);
+  }
+
+  return t;
+}
+
+std::unique_ptr<CommonToken> PooledTokenFactory::create(size_t type, const std::string &text) {
+  return std::unique_ptr<CommonToken>(new (allocate()) PooledToken(type, text));
+}
+
+size_t PooledTokenFactory::getCapacity() const {
+  return _pool->capacity;
+}
+
+void PooledTokenFactory::deallocate(void *p) {
+  if (p == nullptr) {
+    return;
+  }
+
+  Slot *slot = reinterpret_cast<Slot *>(static_cast<char *>(p) - offsetof(Slot, token));
+  Pool *pool = slot->pool;
+
+  Slot *head = pool->returned.load(std::memory_order_relaxed);
+  do {
+    slot->next = head;
+  } while (!pool->returned.compare_exchange_weak(head, slot, std::memory_order_release, std::memory_order_relaxed));
+
+  pool->release();
+}
+
+void* PooledTokenFactory::allocate() {
+  Pool &pool = *_pool;
+  if (pool.free == nullptr) {
+    pool.free = pool.returned.exchange(nullptr, std::memory_order_acquire);
+  }
+
+  if (pool.free == nullptr) {
+    Slot *slab = new Slot[SLAB_SIZE];
+    pool.slabs.emplace_back(slab);
+    pool.capacity += SLAB_SIZE;
+    for (size_t i = 0; i < SLAB_SIZE; ++i) {
+      slab[i].pool = _pool;
+      slab[i].next = i + 1 < SLAB_SIZE ? &slab[i + 1] : nullptr;
+    }
+    pool.free = slab;
+  }
+
+  Slot *slot = pool.free;
+  pool.free = slot->next;
+  pool.references.fetch_add(1, std::memory_order_relaxed);
+  return &slot->token;
+}
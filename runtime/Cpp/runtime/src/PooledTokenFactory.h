@@ -0,0 +1,72 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#pragma once
+
+#include "CommonToken.h"
+#include "TokenFactory.h"
+
+namespace antlr4 {
+
+  /// A CommonToken whose memory comes from a PooledTokenFactory. Deleting it returns the memory to the pool of the
+  /// factory.
+  class ANTLR4CPP_PUBLIC PooledToken : public CommonToken {
+  public:
+    PooledToken(std::pair<TokenSource *, CharStream *> source, size_t type, size_t channel, size_t start, size_t stop);
+    PooledToken(size_t type, const std::string &text);
+
+    static void* operator new(size_t size, void *p) noexcept;
+    static void* operator new(size_t size) = delete;
+    static void operator delete(void *p) noexcept;
+  };
+
+  /// A token factory which allocates its tokens from slabs of SLAB_SIZE tokens and reuses the memory of deleted
+  /// tokens. Lexing with it does not allocate once enough tokens were created for the tokens alive at the same
+  /// time, e.g. when the tokens are consumed and deleted as they are produced, or converted by a token stream with
+  /// compact token storage.
+  ///
+  /// The token text is not copied: like with CommonTokenFactory::DEFAULT, a token keeps only its start and stop index
+  /// and gets its text from the input stream when asked for it. Streams which discard their text (like
+  /// UnbufferedCharStream and PushCharStream) need a CommonTokenFactory which copies the text instead.
+  ///
+  /// Tokens may outlive the factory and may be deleted from any thread, the memory is freed when the factory and all
+  /// of its tokens are gone. Only one thread may create tokens at a time.
+  class ANTLR4CPP_PUBLIC PooledTokenFactory : public TokenFactory<CommonToken> {
+  public:
+#if __cplusplus >= 201703L
+    static constexpr size_t SLAB_SIZE = 1024;
+#else
+    enum : size_t {
+      SLAB_SIZE = 1024,
+    };
+#endif
+
+    PooledTokenFactory();
+    PooledTokenFactory(const PooledTokenFactory &) = delete;
+    virtual ~PooledTokenFactory();
+
+    PooledTokenFactory& operator = (const PooledTokenFactory &) = delete;
+
+    virtual std::unique_ptr<CommonToken> create(std::pair<TokenSource*, CharStream*> source, size_t type,
+      const std::string &text, size_t channel, size_t start, size_t stop, size_t line, size_t charPositionInLine) override;
+
+    virtual std::unique_ptr<CommonToken> create(size_t type, const std::string &text) override;
+
+    /// The number of tokens for which memory was allocated so far.
+    size_t getCapacity() const;
+
+    /// Returns the memory of a token to its pool. Called when a PooledToken is deleted.
+    static void deallocate(void *p);
+
+  private:
+    struct Pool;
+    struct Slot;
+
+    Pool *_pool;
+
+    void* allocate();
+  };
+
+} // namespace antlr4
@@ -0,0 +1,249 @@
+/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#include "misc/Interval.h"
+#include "Exceptions.h"
+#include "support/Unicode.h"
+
+#include "PushCharStream.h"
+
+using namespace antlrcpp;
+using namespace antlr4;
+using namespace antlr4::misc;
+
+namespace {
+
+  // Returns the length of data without an incomplete UTF-8 sequence at its end. Invalid sequences are left for the
+  // decoder to report.
+  size_t completeLength(const char *data, size_t length) {
+    size_t start = length;
+    while (start > 0 && length - start < 4) {
+      --start;
+      if ((static_cast<unsigned char>(data[start]) & 0xC0) != 0x80) {
+        break;
+      }
+    }
+    if (start == length) {
+      return length;
+    }
+
+    unsigned char lead = static_cast<unsigned char>(data[start]);
+    size_t needed = 1;
+    if (lead >= 0xF0) {
+      needed = 4;
+    } else if (lead >= 0xE0) {
+      needed = 3;
+    } else if (lead >= 0xC0) {
+      needed = 2;
+    }
+    return start + needed <= length ? length : start;
+  }
+
+}
+
+PushCharStream::PushCharStream() {
+  InitializeInstanceFields();
+}
+
+void PushCharStream::push(const char *data, size_t length) {
+  if (_closed) {
+    throw IllegalStateException("cannot push input after close()");
+  }
+
+  std::string joined;
+  if (!_pending.empty()) {
+    joined = _pending;
+    joined.append(data, length);
+    data = joined.data();
+    length = joined.size();
+  }
+
+  if (!_started) {
+    // Skip the UTF-8 BOM if present, wait for more input if it is not clear yet.
+    const char bom[4] = "\xef\xbb\xbf";
+    size_t prefix = std::min(length, static_cast<size_t>(3));
+    if (std::equal(data, data + prefix, bom)) {
+      if (length < 3) {
+        _pending.assign(data, length);
+        return;
+      }
+      data += 3;
+      length -= 3;
+    }
+    _started = true;
+  }
+
+  // Drop the text which is no longer needed before the buffer grows.
+  if (_start > 0) {
+    _data.erase(0, _start);
+    _bufferStartIndex += _start;
+    _p -= _start;
+    _start = 0;
+  }
+
+  size_t complete = completeLength(data, length);
+  decodeUtf8(data, data + complete, _data);
+  _pending.assign(data + complete, data + length);
+}
+
+void PushCharStream::push(const std::string &chunk) {
+  push(chunk.data(), chunk.size());
+}
+
+void PushCharStream::close() {
+  if (_closed) {
+    return;
+  }
+
+  if (!_pending.empty()) {
+    decodeUtf8(_pending.data(), _pending.data() + _pending.size(), _data);
+    _pending.clear();
+  }
+  _started = true;
+  _closed = true;
+}
+
+bool PushCharStream::isClosed() const {
+  return _closed;
+}
+
+size_t PushCharStream::available() const {
+  return _data.size() - _p;
+}
+
+void PushCharStream::consume() {
+  if (_p >= _data.size()) {
+    if (_closed) {
+      throw IllegalStateException("cannot consume EOF");
+    }
+    outOfInput();
+  }
+
+  _p++;
+}
+
+size_t PushCharStream::LA(ssize_t i) {
+  if (i == 0) {
+    return 0; // undefined
+  }
+
+  if (i < 0) {
+    if (static_cast<ssize_t>(_bufferStartIndex + _p) + i < 0) {
+      return EOF; // invalid; no char before first char
+    }
+
+    // We can look back only as far as we have buffered.
+    ssize_t index = static_cast<ssize_t>(_p) + i;
+    if (index < static_cast<ssize_t>(_start)) {
+      throw IndexOutOfBoundsException();
+    }
+    return static_cast<size_t>(_data[static_cast<size_t>(index)]);
+  }
+
+  size_t index = _p + static_cast<size_t>(i) - 1;
+  if (index >= _data.size()) {
+    return outOfInput();
+  }
+  return static_cast<size_t>(_data[index]);
+}
+
+ssize_t PushCharStream::mark() {
+  if (_numMarkers == 0) {
+    _keepBuffer = false;
+  }
+
+  ssize_t mark = -static_cast<ssize_t>(_numMarkers) - 1;
+  _numMarkers++;
+  return mark;
+}
+
+void PushCharStream::release(ssize_t marker) {
+  ssize_t expectedMark = -static_cast<ssize_t>(_numMarkers);
+  if (marker != expectedMark) {
+    throw IllegalStateException("release() called with an invalid marker.");
+  }
+
+  _numMarkers--;
+  if (_numMarkers == 0 && !_keepBuffer && _p > 0) {
+    // Keep one character for LA(-1).
+    _start = std::max(_start, _p - 1);
+  }
+}
+
+size_t PushCharStream::index() {
+  return _bufferStartIndex + _p;
+}
+
+void PushCharStream::seek(size_t index) {
+  if (index < _bufferStartIndex + _start) {
+    throw UnsupportedOperationException("Seek to index outside buffer: " + std::to_string(index) +
+                                        " not in " + std::to_string(_bufferStartIndex + _start) + ".." +
+                                        std::to_string(_bufferStartIndex + _data.size()));
+  }
+
+  size_t p = index - _bufferStartIndex;
+  if (p > _data.size()) {
+    outOfInput();
+    p = _data.size();
+  }
+  _p = p;
+}
+
+size_t PushCharStream::size() {
+  if (!_closed) {
+    throw UnsupportedOperationException("The size of a push stream is only known after close()");
+  }
+  return _bufferStartIndex + _data.size();
+}
+
+std::string PushCharStream::getSourceName() const {
+  if (name.empty()) {
+    return UNKNOWN_SOURCE_NAME;
+  }
+
+  return name;
+}
+
+std::string PushCharStream::getText(const misc::Interval &interval) {
+  if (interval.a < 0 || interval.b < interval.a - 1) {
+    throw IllegalArgumentException("invalid interval");
+  }
+
+  size_t first = static_cast<size_t>(interval.a);
+  size_t last = static_cast<size_t>(interval.b + 1);
+  if (first < _bufferStartIndex + _start || last > _bufferStartIndex + _data.size()) {
+    throw UnsupportedOperationException("interval " + interval.toString() + " outside buffer: " +
+      std::to_string(_bufferStartIndex + _start) + ".." + std::to_string(_bufferStartIndex + _data.size() - 1));
+  }
+
+  const char32_t *data = reinterpret_cast<const char32_t *>(_data.data());
+  return encodeUtf8(data + (first - _bufferStartIndex), data + (last - _bufferStartIndex));
+}
+
+std::string PushCharStream::toString() const {
+  const char32_t *data = reinterpret_cast<const char32_t *>(_data.data());
+  return encodeUtf8(data + _start, data + _data.size());
+}
+
+size_t PushCharStream::outOfInput() {
+  if (_closed) {
+    return EOF;
+  }
+
+  if (_numMarkers > 0) {
+    _keepBuffer = true;
+  }
+  throw IncompleteInputException("more input is needed at index " + std::to_string(_bufferStartIndex + _data.size()));
+}
+
+void PushCharStream::InitializeInstanceFields() {
+  _bufferStartIndex = 0;
+  _start = 0;
+  _p = 0;
+  _numMarkers = 0;
+  _keepBuffer = false;
+  _started = false;
+  _closed = false;
+}
@@ -0,0 +1,93 @@
+/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#pragma once
+
+#include "CharStream.h"
+
+namespace antlr4 {
+
+  /// A char stream to which the input is pushed in chunks of UTF-8, as it arrives from a socket or a pipe, instead
+  /// of being available up front. Only the text of the current token and the input not yet lexed are kept, so
+  /// arbitrarily large inputs can be lexed with bounded memory.
+  ///
+  /// When the lexer needs a character which has not been pushed yet, and close() was not called, the stream throws
+  /// an IncompleteInputException instead of returning EOF. Lexer::nextToken() then rewinds to where it left off
+  /// and passes the exception on; call nextToken() (or fill() on the token stream) again after pushing more input.
+  /// A lexer sees EOF only after close().
+  ///
+  /// The text of earlier tokens is dropped from the buffer, so tokens must copy their text when they are created:
+  /// give the lexer a CommonTokenFactory constructed with copyText = true.
+  class ANTLR4CPP_PUBLIC PushCharStream : public CharStream {
+  public:
+    /// The name or source of this char stream.
+    std::string name;
+
+    PushCharStream();
+
+    /// Appends a chunk of UTF-8 input. A chunk may end in the middle of a character, the rest of it is expected
+    /// in the next chunk. A UTF-8 BOM at the start of the input is skipped.
+    /// @throws std::range_error if the chunk is not valid UTF-8.
+    /// @throws IllegalStateException if the stream was closed.
+    virtual void push(const char *data, size_t length);
+    virtual void push(const std::string &chunk);
+
+    /// Marks the end of the input. From now on the stream returns EOF after the last character.
+    /// @throws std::range_error if the input ends with an incomplete character.
+    virtual void close();
+
+    bool isClosed() const;
+
+    /// Returns the number of characters which were pushed but not consumed yet.
+    size_t available() const;
+
+    virtual void consume() override;
+    virtual size_t LA(ssize_t i) override;
+
+    virtual ssize_t mark() override;
+    virtual void release(ssize_t marker) override;
+    virtual size_t index() override;
+
+    /// Seeks to an absolute character index, which must still be buffered.
+    virtual void seek(size_t index) override;
+
+    /// The size is only known after close().
+    virtual size_t size() override;
+    virtual std::string getSourceName() const override;
+    virtual std::string getText(const misc::Interval &interval) override;
+
+    /// Returns the text still in the buffer.
+    virtual std::string toString() const override;
+
+  protected:
+    /// The buffered characters. _data[0] has the absolute index _bufferStartIndex, the characters before _start are
+    /// no longer needed and are removed when more input is pushed.
+    UTF32String _data;
+    size_t _bufferStartIndex;
+    size_t _start;
+
+    /// Index into _data of the next character.
+    size_t _p;
+
+    size_t _numMarkers;
+
+    /// Set when the stream ran out of input while markers were held. The markers are then released while the lexer
+    /// unwinds, but it needs the buffered text again when it is resumed, so the buffer is kept until the next mark.
+    bool _keepBuffer;
+
+    /// Bytes of an incomplete character at the end of the last chunk (or the first bytes of the input, as long as
+    /// they might still be a BOM).
+    std::string _pending;
+    bool _started;
+    bool _closed;
+
+    /// Throws IncompleteInputException, or returns EOF if the stream was closed.
+    size_t outOfInput();
+
+  private:
+    void InitializeInstanceFields();
+  };
+
+} // namespace antlr4
@@ -50,14 +50,17 @@ std::string RuleContext::getText() {
     return "";
   }
 
-  std::stringstream ss;
+  std::string text;
+  appendText(text);
+  return text;
+}
+
+void RuleContext::appendText(std::string &text) {
   for (size_t i = 0; i < children.size(); i++) {
     ParseTree *tree = children[i];
     if (tree != nullptr)
-      ss << tree->getText();
+      tree->appendText(text);
   }
-
-  return ss.str();
 }
 
 size_t RuleContext::getRuleIndex() const {
@@ -138,6 +141,7 @@ std::string RuleContext::toString(Recognizer *recog, RuleContext *stop) {
 }
 
 void RuleContext::InitializeInstanceFields() {
+  _treeType = tree::ParseTreeType::RULE;
   invokingState = INVALID_INDEX;
 }
 
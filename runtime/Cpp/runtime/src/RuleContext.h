@@ -79,6 +79,7 @@ namespace antlr4 {
     virtual misc::Interval getSourceInterval() override;
 
     virtual std::string getText() override;
+    virtual void appendText(std::string &text) override;
 
     virtual size_t getRuleIndex() const;
 
@@ -7,3 +7,7 @@
 
 antlr4::Token::~Token() {
 }
+
+bool antlr4::Token::getTextView(antlrcpp::StringView &/*text*/) const {
+  return false;
+}
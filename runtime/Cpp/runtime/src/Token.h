@@ -6,6 +6,7 @@
 #pragma once
 
 #include "IntStream.h"
+#include "support/StringView.h"
 
 namespace antlr4 {
 
@@ -81,6 +82,11 @@ namespace antlr4 {
     /// Get the text of the token.
     virtual std::string getText() const = 0;
 
+    /// Stores a view of the token text in {@code text} and returns true if the text is available without copying it,
+    /// e.g. in the buffer of a UTF-8 input stream. The view stays valid as long as the token and its input stream
+    /// are not changed. Returns false, which is the default, if the text can only be had from getText().
+    virtual bool getTextView(antlrcpp::StringView &text) const;
+
     /// Get the token type of the token
     virtual size_t getType() const = 0;
 
@@ -3,7 +3,21 @@
  * can be found in the LICENSE.txt file in the project root.
  */
 
+#include "Token.h"
+
 #include "TokenSource.h"
 
 antlr4::TokenSource::~TokenSource() {
 }
+
+size_t antlr4::TokenSource::nextTokens(std::vector<std::unique_ptr<Token>> &tokens, size_t maxCount) {
+  size_t count = 0;
+  while (count < maxCount) {
+    tokens.push_back(nextToken());
+    ++count;
+    if (tokens.back()->getType() == Token::EOF) {
+      break;
+    }
+  }
+  return count;
+}
@@ -34,6 +34,13 @@ namespace antlr4 {
     /// to the parser.
     virtual std::unique_ptr<Token> nextToken() = 0;
 
+    /// Appends up to {@code maxCount} tokens to {@code tokens} as if nextToken() was called for each of them and
+    /// returns the number of tokens added. Stops after the EOF token. If nextToken() throws, the tokens created before
+    /// stay in {@code tokens}. Token streams fetch their tokens in batches with this method. The default
+    /// implementation simply calls nextToken() for each token. Token sources which can produce tokens in bulk more
+    /// cheaply may override it, like ParallelTokenSource and Lexer (see Lexer::setTokenBatchingEnabled()).
+    virtual size_t nextTokens(std::vector<std::unique_ptr<Token>> &tokens, size_t maxCount);
+
     /// <summary>
     /// Get the line number for the current position in the input stream. The
     /// first line in the input is line 1.
@@ -0,0 +1,324 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#include "CharStream.h"
+#include "CommonToken.h"
+#include "Exceptions.h"
+#include "PooledTokenFactory.h"
+#include "Recognizer.h"
+#include "Vocabulary.h"
+
+#include "misc/Interval.h"
+
+#include "support/StringUtils.h"
+
+#include "TokenStore.h"
+
+using namespace antlr4;
+using namespace antlr4::misc;
+
+using namespace antlrcpp;
+
+namespace {
+
+  // INVALID_INDEX (which is also EOF) is stored as the largest 32-bit value.
+  const uint32_t NO_VALUE = std::numeric_limits<uint32_t>::max();
+
+  bool fits(size_t value) {
+    return value == INVALID_INDEX || value < NO_VALUE;
+  }
+
+  uint32_t pack(size_t value) {
+    return value == INVALID_INDEX ? NO_VALUE : static_cast<uint32_t>(value);
+  }
+
+  size_t unpack(uint32_t value) {
+    return value == NO_VALUE ? INVALID_INDEX : value;
+  }
+
+}
+
+struct TokenStore::Chunk {
+  uint32_t columns[COLUMN_COUNT][CHUNK_SIZE];
+  std::aligned_storage<sizeof(CompactToken), alignof(CompactToken)>::type tokens[CHUNK_SIZE];
+};
+
+//----------------- CompactToken ---------------------------------------------------------------------------------------
+
+CompactToken::CompactToken(TokenStore *store, uint32_t slot, uint32_t index)
+  : _store(store), _slot(slot), _index(index) {
+}
+
+void* CompactToken::operator new(size_t /*size*/, void *p) noexcept {
+  return p;
+}
+
+void CompactToken::operator delete(void * /*p*/) noexcept {
+  // The memory belongs to the store.
+}
+
+size_t CompactToken::getType() const {
+  return _store->get(TokenStore::TYPE, _slot);
+}
+
+void CompactToken::setType(size_t type) {
+  _store->set(TokenStore::TYPE, _slot, type);
+}
+
+std::string CompactToken::getText() const {
+  const std::string *text = _store->getExplicitText(_slot);
+  if (text != nullptr) {
+    return *text;
+  }
+
+  CharStream *input = getInputStream();
+  if (input == nullptr) {
+    return "";
+  }
+  size_t start = getStartIndex();
+  size_t stop = getStopIndex();
+  size_t n = input->size();
+  if (start < n && stop < n) {
+    return input->getText(misc::Interval(start, stop));
+  } else {
+    return "<EOF>";
+  }
+}
+
+bool CompactToken::getTextView(antlrcpp::StringView &text) const {
+  const std::string *explicitText = _store->getExplicitText(_slot);
+  if (explicitText != nullptr) {
+    text = *explicitText;
+    return true;
+  }
+
+  CharStream *input = getInputStream();
+  if (input == nullptr) {
+    text = "";
+    return true;
+  }
+  size_t start = getStartIndex();
+  size_t stop = getStopIndex();
+  size_t n = input->size();
+  if (start < n && stop < n) {
+    return input->getTextView(misc::Interval(start, stop), text);
+  } else {
+    text = "<EOF>";
+    return true;
+  }
+}
+
+void CompactToken::setText(const std::string &text) {
+  if (text.empty()) {
+    _store->_texts.erase(_slot);
+  } else {
+    _store->_texts[_slot] = text;
+  }
+}
+
+size_t CompactToken::getLine() const {
+  return _store->get(TokenStore::LINE, _slot);
+}
+
+void CompactToken::setLine(size_t line) {
+  _store->set(TokenStore::LINE, _slot, line);
+}
+
+size_t CompactToken::getCharPositionInLine() const {
+  return _store->get(TokenStore::COLUMN, _slot);
+}
+
+void CompactToken::setCharPositionInLine(size_t pos) {
+  _store->set(TokenStore::COLUMN, _slot, pos);
+}
+
+size_t CompactToken::getChannel() const {
+  return _store->get(TokenStore::CHANNEL, _slot);
+}
+
+void CompactToken::setChannel(size_t channel) {
+  _store->set(TokenStore::CHANNEL, _slot, channel);
+}
+
+size_t CompactToken::getTokenIndex() const {
+  return unpack(_index);
+}
+
+void CompactToken::setTokenIndex(size_t index) {
+  if (!fits(index)) {
+    throw IllegalArgumentException("token index " + std::to_string(index) + " is too large for a compact token");
+  }
+  _index = pack(index);
+}
+
+size_t CompactToken::getStartIndex() const {
+  return _store->get(TokenStore::START, _slot);
+}
+
+size_t CompactToken::getStopIndex() const {
+  return _store->get(TokenStore::STOP, _slot);
+}
+
+TokenSource* CompactToken::getTokenSource() const {
+  return _store->_source.first;
+}
+
+CharStream* CompactToken::getInputStream() const {
+  return _store->_source.second;
+}
+
+std::string CompactToken::toString() const {
+  return toString(nullptr);
+}
+
+std::string CompactToken::toString(Recognizer *r) const {
+  // Same format as CommonToken::toString().
+  std::stringstream ss;
+
+  size_t channel = getChannel();
+  std::string channelStr;
+  if (channel > 0) {
+    channelStr = ",channel=" + std::to_string(channel);
+  }
+  std::string txt = getText();
+  if (!txt.empty()) {
+    antlrcpp::replaceAll(txt, "\n", "\\n");
+    antlrcpp::replaceAll(txt, "\r", "\\r");
+    antlrcpp::replaceAll(txt, "\t", "\\t");
+  } else {
+    txt = "<no text>";
+  }
+
+  size_t type = getType();
+  std::string typeString = std::to_string(symbolToNumeric(type));
+  if (r != nullptr)
+    typeString = r->getVocabulary().getDisplayName(type);
+
+  ss << "[@" << symbolToNumeric(getTokenIndex()) << "," << symbolToNumeric(getStartIndex()) << ":"
+    << symbolToNumeric(getStopIndex()) << "='" << txt << "',<" << typeString << ">" << channelStr << ","
+    << getLine() << ":" << getCharPositionInLine() << "]";
+
+  return ss.str();
+}
+
+//----------------- TokenStore -----------------------------------------------------------------------------------------
+
+TokenStore::TokenStore() : _size(0) {
+}
+
+TokenStore::~TokenStore() {
+  clear();
+}
+
+std::unique_ptr<Token> TokenStore::add(const Token &token) {
+  // Other classes derived from CommonToken may have more state, which would be lost. PooledToken only changes where
+  // the memory comes from.
+  if (typeid(token) != typeid(CommonToken) && typeid(token) != typeid(PooledToken)) {
+    return nullptr;
+  }
+  const CommonToken &common = static_cast<const CommonToken &>(token);
+
+  if (_size == 0) {
+    _source = common._source;
+  } else if (common._source != _source) {
+    return nullptr;
+  }
+
+  if (!fits(common._type) || !fits(common._channel) || !fits(common._start) || !fits(common._stop) ||
+      !fits(common._line) || !fits(common._charPositionInLine) || !fits(common._index) || _size >= NO_VALUE) {
+    return nullptr;
+  }
+
+  size_t chunk = _size / CHUNK_SIZE;
+  size_t offset = _size % CHUNK_SIZE;
+  if (chunk == _chunks.size()) {
+    _chunks.push_back(new Chunk);
+  }
+
+  Chunk *target = _chunks[chunk];
+  target->columns[TYPE][offset] = pack(common._type);
+  target->columns[CHANNEL][offset] = pack(common._channel);
+  target->columns[START][offset] = pack(common._start);
+  target->columns[STOP][offset] = pack(common._stop);
+  target->columns[LINE][offset] = pack(common._line);
+  target->columns[COLUMN][offset] = pack(common._charPositionInLine);
+  if (!common._text.empty()) {
+    _texts[_size] = common._text;
+  }
+
+  CompactToken *result = new (&target->tokens[offset]) CompactToken(this, static_cast<uint32_t>(_size),
+    pack(common._index));
+  ++_size;
+  return std::unique_ptr<Token>(result);
+}
+
+size_t TokenStore::size() const {
+  return _size;
+}
+
+void TokenStore::clear() {
+  for (Chunk *chunk : _chunks) {
+    delete chunk;
+  }
+  _chunks.clear();
+  _size = 0;
+  _source = { nullptr, nullptr };
+  _texts.clear();
+}
+
+size_t TokenStore::getType(size_t slot) const {
+  return get(TYPE, slot);
+}
+
+size_t TokenStore::getChannel(size_t slot) const {
+  return get(CHANNEL, slot);
+}
+
+size_t TokenStore::getStartIndex(size_t slot) const {
+  return get(START, slot);
+}
+
+size_t TokenStore::getStopIndex(size_t slot) const {
+  return get(STOP, slot);
+}
+
+size_t TokenStore::getLine(size_t slot) const {
+  return get(LINE, slot);
+}
+
+size_t TokenStore::getCharPositionInLine(size_t slot) const {
+  return get(COLUMN, slot);
+}
+
+const std::string* TokenStore::getExplicitText(size_t slot) const {
+  if (_texts.empty()) {
+    return nullptr;
+  }
+
+  auto iterator = _texts.find(slot);
+  if (iterator == _texts.end()) {
+    return nullptr;
+  }
+  return &iterator->second;
+}
+
+TokenSource* TokenStore::getTokenSource() const {
+  return _source.first;
+}
+
+CharStream* TokenStore::getInputStream() const {
+  return _source.second;
+}
+
+size_t TokenStore::get(Column column, size_t slot) const {
+  return unpack(_chunks[slot / CHUNK_SIZE]->columns[column][slot % CHUNK_SIZE]);
+}
+
+void TokenStore::set(Column column, size_t slot, size_t value) {
+  if (!fits(value)) {
+    throw IllegalArgumentException("value " + std::to_string(value) + " is too large for a compact token");
+  }
+  _chunks[slot / CHUNK_SIZE]->columns[column][slot % CHUNK_SIZE] = pack(value);
+}
@@ -0,0 +1,137 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#pragma once
+
+#include "WritableToken.h"
+
+namespace antlr4 {
+
+  /// A token kept in a TokenStore. The object only refers to its slot in the store, the values live in the columns
+  /// of the store. Compact tokens are created by the store and their memory belongs to it: deleting one (e.g. through
+  /// the std::unique_ptr<Token> which holds it in a token stream) only runs the destructor. The store must therefore
+  /// outlive all of its tokens.
+  class ANTLR4CPP_PUBLIC CompactToken : public WritableToken {
+  public:
+    CompactToken(TokenStore *store, uint32_t slot, uint32_t index);
+
+    static void* operator new(size_t size, void *p) noexcept;
+    static void* operator new(size_t size) = delete;
+    static void operator delete(void *p) noexcept;
+
+    virtual size_t getType() const override;
+    virtual void setType(size_t type) override;
+
+    virtual std::string getText() const override;
+    virtual bool getTextView(antlrcpp::StringView &text) const override;
+    virtual void setText(const std::string &text) override;
+
+    virtual size_t getLine() const override;
+    virtual void setLine(size_t line) override;
+
+    virtual size_t getCharPositionInLine() const override;
+    virtual void setCharPositionInLine(size_t pos) override;
+
+    virtual size_t getChannel() const override;
+    virtual void setChannel(size_t channel) override;
+
+    virtual size_t getTokenIndex() const override;
+    virtual void setTokenIndex(size_t index) override;
+
+    virtual size_t getStartIndex() const override;
+    virtual size_t getStopIndex() const override;
+
+    virtual TokenSource *getTokenSource() const override;
+    virtual CharStream *getInputStream() const override;
+
+    virtual std::string toString() const override;
+    virtual std::string toString(Recognizer *r) const;
+
+  private:
+    TokenStore *_store;
+    uint32_t _slot;
+    uint32_t _index;
+  };
+
+  /// Stores the values of tokens as a struct of arrays: type, channel, start, stop, line and column are kept in
+  /// 32-bit columns, in chunks of CHUNK_SIZE tokens, together with the CompactToken objects which give access to them
+  /// through the Token interface. Storing n tokens takes n / CHUNK_SIZE allocations and about 50 bytes per token,
+  /// instead of one CommonToken of more than 100 bytes (plus malloc overhead) each.
+  ///
+  /// All tokens of a store come from the same token source and input stream. Explicitly set token texts are kept in
+  /// a separate map, since most tokens take their text from the input stream.
+  ///
+  /// Enable it for a token stream with BufferedTokenStream::setCompactTokenStorage().
+  class ANTLR4CPP_PUBLIC TokenStore {
+  public:
+#if __cplusplus >= 201703L
+    static constexpr size_t CHUNK_SIZE = 4096;
+#else
+    enum : size_t {
+      CHUNK_SIZE = 4096,
+    };
+#endif
+
+    TokenStore();
+    TokenStore(const TokenStore &) = delete;
+    ~TokenStore();
+
+    TokenStore& operator = (const TokenStore &) = delete;
+
+    /// Copies the values of {@code token} into the store and returns the compact token which replaces it. Returns
+    /// nullptr if the token cannot be stored: if it is not exactly a CommonToken or a PooledToken (other derived
+    /// classes might have more state), comes from another source than the tokens before, or has a value which does not fit in 32 bits.
+    std::unique_ptr<Token> add(const Token &token);
+
+    /// The number of tokens in the store.
+    size_t size() const;
+
+    /// Releases all memory. All tokens of the store must have been deleted before.
+    void clear();
+
+    size_t getType(size_t slot) const;
+    size_t getChannel(size_t slot) const;
+    size_t getStartIndex(size_t slot) const;
+    size_t getStopIndex(size_t slot) const;
+    size_t getLine(size_t slot) const;
+    size_t getCharPositionInLine(size_t slot) const;
+
+    /// Returns the explicitly set text of a token, or nullptr if it takes its text from the input stream.
+    const std::string* getExplicitText(size_t slot) const;
+
+    TokenSource* getTokenSource() const;
+    CharStream* getInputStream() const;
+
+  protected:
+    friend class CompactToken;
+
+    enum Column {
+      TYPE,
+      CHANNEL,
+      START,
+      STOP,
+      LINE,
+      COLUMN,
+      COLUMN_COUNT
+    };
+
+    struct Chunk;
+
+    std::vector<Chunk *> _chunks;
+    size_t _size;
+
+    /// The token source and input stream of all tokens.
+    std::pair<TokenSource *, CharStream *> _source;
+
+    /// The explicitly set texts, by slot.
+    std::unordered_map<size_t, std::string> _texts;
+
+    size_t get(Column column, size_t slot) const;
+
+    /// Stores a value, throws IllegalArgumentException if it does not fit in 32 bits.
+    void set(Column column, size_t slot, size_t value);
+  };
+
+} // namespace antlr4
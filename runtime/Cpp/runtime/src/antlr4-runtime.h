@@ -31,12 +31,17 @@
 #include "Lexer.h"
 #include "LexerInterpreter.h"
 #include "LexerNoViableAltException.h"
+#include "LineIndex.h"
 #include "ListTokenSource.h"
+#include "MappedFileStream.h"
 #include "NoViableAltException.h"
+#include "ParallelTokenSource.h"
 #include "Parser.h"
 #include "ParserInterpreter.h"
 #include "ParserRuleContext.h"
+#include "PooledTokenFactory.h"
 #include "ProxyErrorListener.h"
+#include "PushCharStream.h"
 #include "RecognitionException.h"
 #include "Recognizer.h"
 #include "RuleContext.h"
@@ -45,6 +50,7 @@
 #include "Token.h"
 #include "TokenFactory.h"
 #include "TokenSource.h"
+#include "TokenStore.h"
 #include "TokenStream.h"
 #include "TokenStreamRewriter.h"
 #include "UnbufferedCharStream.h"
@@ -70,6 +76,7 @@
 #include "atn/BasicState.h"
 #include "atn/BlockEndState.h"
 #include "atn/BlockStartState.h"
+#include "atn/CharClassMap.h"
 #include "atn/ContextSensitivityInfo.h"
 #include "atn/DecisionEventInfo.h"
 #include "atn/DecisionInfo.h"
@@ -121,6 +128,7 @@
 #include "atn/WildcardTransition.h"
 #include "dfa/DFA.h"
 #include "dfa/DFASerializer.h"
+#include "dfa/DFASnapshot.h"
 #include "dfa/DFAState.h"
 #include "dfa/LexerDFASerializer.h"
 #include "misc/InterpreterDataReader.h"
@@ -129,15 +137,22 @@
 #include "misc/MurmurHash.h"
 #include "misc/Predicate.h"
 #include "support/Any.h"
+#include "support/Arena.h"
 #include "support/Arrays.h"
 #include "support/BitSet.h"
 #include "support/CPPUtils.h"
+#include "support/IntrusivePtr.h"
 #include "support/StringUtils.h"
+#include "support/StringView.h"
+#include "support/Unicode.h"
 #include "support/guid.h"
 #include "tree/AbstractParseTreeVisitor.h"
+#include "tree/DenseParseTreeProperty.h"
 #include "tree/ErrorNode.h"
 #include "tree/ErrorNodeImpl.h"
+#include "tree/FlatParseTree.h"
 #include "tree/ParseTree.h"
+#include "tree/ParseTreeArena.h"
 #include "tree/ParseTreeListener.h"
 #include "tree/ParseTreeProperty.h"
 #include "tree/ParseTreeVisitor.h"
@@ -34,6 +34,7 @@ ATN::ATN(ATN &&other) {
   ruleToTokenType = std::move(other.ruleToTokenType);
   lexerActions = std::move(other.lexerActions);
   modeToStartState = std::move(other.modeToStartState);
+  charClasses = std::move(other.charClasses);
 }
 
 ATN::ATN(ATNType grammarType_, size_t maxTokenType_) : grammarType(grammarType_), maxTokenType(maxTokenType_) {
@@ -58,6 +59,7 @@ ATN& ATN::operator = (ATN &other) NOEXCEPT {
   ruleToTokenType = other.ruleToTokenType;
   lexerActions = other.lexerActions;
   modeToStartState = other.modeToStartState;
+  charClasses = other.charClasses;
 
   return *this;
 }
@@ -77,6 +79,7 @@ ATN& ATN::operator = (ATN &&other) NOEXCEPT {
   ruleToTokenType = std::move(other.ruleToTokenType);
   lexerActions = std::move(other.lexerActions);
   modeToStartState = std::move(other.modeToStartState);
+  charClasses = std::move(other.charClasses);
 
   return *this;
 }
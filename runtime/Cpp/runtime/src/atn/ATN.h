@@ -6,6 +6,7 @@
 #pragma once
 
 #include "RuleContext.h"
+#include "atn/CharClassMap.h"
 
 namespace antlr4 {
 namespace atn {
@@ -60,6 +61,10 @@ namespace atn {
 
     std::vector<TokensStartState *> modeToStartState;
 
+    /// For lexer ATNs, the equivalence classes of the code points above the lexer's direct DFA edge range,
+    /// computed by the ATNDeserializer. The lexer keys its DFA edges for such input by class.
+    CharClassMap charClasses;
+
     ATN& operator = (ATN &other) NOEXCEPT;
     ATN& operator = (ATN &&other) NOEXCEPT;
 
@@ -10,12 +10,13 @@
 #include "atn/ATNConfig.h"
 
 using namespace antlr4::atn;
+using namespace antlrcpp;
 
-ATNConfig::ATNConfig(ATNState *state_, size_t alt_, Ref<PredictionContext> const& context_)
+ATNConfig::ATNConfig(ATNState *state_, size_t alt_, IntrusivePtr<PredictionContext> const& context_)
   : ATNConfig(state_, alt_, context_, SemanticContext::NONE) {
 }
 
-ATNConfig::ATNConfig(ATNState *state_, size_t alt_, Ref<PredictionContext> const& context_, Ref<SemanticContext> const& semanticContext_)
+ATNConfig::ATNConfig(ATNState *state_, size_t alt_, IntrusivePtr<PredictionContext> const& context_, Ref<SemanticContext> const& semanticContext_)
   : state(state_), alt(alt_), context(context_), semanticContext(semanticContext_) {
   reachesIntoOuterContext = 0;
 }
@@ -34,11 +35,11 @@ ATNConfig::ATNConfig(Ref<ATNConfig> const& c, Ref<SemanticContext> const& semant
   : ATNConfig(c, c->state, c->context, semanticContext) {
 }
 
-ATNConfig::ATNConfig(Ref<ATNConfig> const& c, ATNState *state, Ref<PredictionContext> const& context)
+ATNConfig::ATNConfig(Ref<ATNConfig> const& c, ATNState *state, IntrusivePtr<PredictionContext> const& context)
   : ATNConfig(c, state, context, c->semanticContext) {
 }
 
-ATNConfig::ATNConfig(Ref<ATNConfig> const& c, ATNState *state, Ref<PredictionContext> const& context,
+ATNConfig::ATNConfig(Ref<ATNConfig> const& c, ATNState *state, IntrusivePtr<PredictionContext> const& context,
                      Ref<SemanticContext> const& semanticContext)
   : state(state), alt(c->alt), context(context), reachesIntoOuterContext(c->reachesIntoOuterContext),
     semanticContext(semanticContext) {
@@ -51,7 +52,7 @@ size_t ATNConfig::hashCode() const {
   size_t hashCode = misc::MurmurHash::initialize(7);
   hashCode = misc::MurmurHash::update(hashCode, state->stateNumber);
   hashCode = misc::MurmurHash::update(hashCode, alt);
-  hashCode = misc::MurmurHash::update(hashCode, context);
+  hashCode = misc::MurmurHash::update(hashCode, context.get());
   hashCode = misc::MurmurHash::update(hashCode, semanticContext);
   hashCode = misc::MurmurHash::finish(hashCode, 4);
   return hashCode;
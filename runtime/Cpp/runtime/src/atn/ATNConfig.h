@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include "atn/PredictionContext.h"
+
 namespace antlr4 {
 namespace atn {
 
@@ -45,7 +47,7 @@ namespace atn {
     /// execution of the ATN simulator.
     ///
     /// Can be shared between multiple ANTConfig instances.
-    Ref<PredictionContext> context;
+    IntrusivePtr<PredictionContext> context;
 
     /**
      * We cannot execute predicates dependent upon local context unless
@@ -75,15 +77,15 @@ namespace atn {
     /// Can be shared between multiple ATNConfig instances.
     Ref<SemanticContext> semanticContext;
 
-    ATNConfig(ATNState *state, size_t alt, Ref<PredictionContext> const& context);
-    ATNConfig(ATNState *state, size_t alt, Ref<PredictionContext> const& context, Ref<SemanticContext> const& semanticContext);
+    ATNConfig(ATNState *state, size_t alt, IntrusivePtr<PredictionContext> const& context);
+    ATNConfig(ATNState *state, size_t alt, IntrusivePtr<PredictionContext> const& context, Ref<SemanticContext> const& semanticContext);
 
     ATNConfig(Ref<ATNConfig> const& c); // dup
     ATNConfig(Ref<ATNConfig> const& c, ATNState *state);
     ATNConfig(Ref<ATNConfig> const& c, ATNState *state, Ref<SemanticContext> const& semanticContext);
     ATNConfig(Ref<ATNConfig> const& c, Ref<SemanticContext> const& semanticContext);
-    ATNConfig(Ref<ATNConfig> const& c, ATNState *state, Ref<PredictionContext> const& context);
-    ATNConfig(Ref<ATNConfig> const& c, ATNState *state, Ref<PredictionContext> const& context, Ref<SemanticContext> const& semanticContext);
+    ATNConfig(Ref<ATNConfig> const& c, ATNState *state, IntrusivePtr<PredictionContext> const& context);
+    ATNConfig(Ref<ATNConfig> const& c, ATNState *state, IntrusivePtr<PredictionContext> const& context, Ref<SemanticContext> const& semanticContext);
 
     ATNConfig(ATNConfig const&) = default;
     virtual ~ATNConfig();
@@ -48,6 +48,7 @@
 #include "atn/LexerPushModeAction.h"
 #include "atn/LexerSkipAction.h"
 #include "atn/LexerTypeAction.h"
+#include "atn/LexerATNSimulator.h"
 
 #include "atn/ATNDeserializer.h"
 
@@ -431,6 +432,11 @@ ATN ATNDeserializer::deserialize(const std::vector<uint16_t>& input) {
     }
   }
 
+  if (atn.grammarType == ATNType::LEXER) {
+    // Input up to MAX_DFA_EDGE is directly indexed in the DFA edge tables, so classes are needed only above that.
+    atn.charClasses = CharClassMap(atn, LexerATNSimulator::MAX_DFA_EDGE + 1);
+  }
+
   markPrecedenceDecisions(atn);
 
   if (deserializationOptions.isVerifyATN()) {
@@ -14,10 +14,9 @@
 using namespace antlr4;
 using namespace antlr4::dfa;
 using namespace antlr4::atn;
+using namespace antlrcpp;
 
 const Ref<DFAState> ATNSimulator::ERROR = std::make_shared<DFAState>(INT32_MAX);
-antlrcpp::SingleWriteMultipleReadLock ATNSimulator::_stateLock;
-antlrcpp::SingleWriteMultipleReadLock ATNSimulator::_edgeLock;
 
 ATNSimulator::ATNSimulator(const ATN &atn, PredictionContextCache &sharedContextCache)
 : atn(atn), _sharedContextCache(sharedContextCache) {
@@ -34,9 +33,9 @@ PredictionContextCache& ATNSimulator::getSharedContextCache() {
   return _sharedContextCache;
 }
 
-Ref<PredictionContext> ATNSimulator::getCachedContext(Ref<PredictionContext> const& context) {
-  // This function must only be called with an active state lock, as we are going to change a shared structure.
-  std::map<Ref<PredictionContext>, Ref<PredictionContext>> visited;
+IntrusivePtr<PredictionContext> ATNSimulator::getCachedContext(IntrusivePtr<PredictionContext> const& context) {
+  // The shared context cache does its own locking, so this can be called while holding only the lock of a single DFA.
+  std::map<IntrusivePtr<PredictionContext>, IntrusivePtr<PredictionContext>> visited;
   return PredictionContext::getCachedContext(context, _sharedContextCache, visited);
 }
 
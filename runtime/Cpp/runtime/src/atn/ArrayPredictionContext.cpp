@@ -9,12 +9,13 @@
 #include "atn/ArrayPredictionContext.h"
 
 using namespace antlr4::atn;
+using namespace antlrcpp;
 
-ArrayPredictionContext::ArrayPredictionContext(Ref<SingletonPredictionContext> const& a)
+ArrayPredictionContext::ArrayPredictionContext(IntrusivePtr<SingletonPredictionContext> const& a)
   : ArrayPredictionContext({ a->parent }, { a->returnState }) {
 }
 
-ArrayPredictionContext::ArrayPredictionContext(std::vector<Ref<PredictionContext>> const& parents_,
+ArrayPredictionContext::ArrayPredictionContext(std::vector<IntrusivePtr<PredictionContext>> const& parents_,
                                                std::vector<size_t> const& returnStates)
   : PredictionContext(calculateHashCode(parents_, returnStates)), parents(parents_), returnStates(returnStates) {
     assert(parents.size() > 0);
@@ -33,7 +34,7 @@ size_t ArrayPredictionContext::size() const {
   return returnStates.size();
 }
 
-Ref<PredictionContext> ArrayPredictionContext::getParent(size_t index) const {
+IntrusivePtr<PredictionContext> ArrayPredictionContext::getParent(size_t index) const {
   return parents[index];
 }
 
@@ -0,0 +1,131 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#include "atn/ATN.h"
+#include "atn/ATNState.h"
+#include "atn/Transition.h"
+#include "misc/IntervalSet.h"
+#include "Lexer.h"
+
+#include "atn/CharClassMap.h"
+
+using namespace antlr4;
+using namespace antlr4::atn;
+
+CharClassMap::CharClassMap() : _size(0), _minCodePoint(0) {
+}
+
+CharClassMap::CharClassMap(const ATN &atn, size_t minCodePoint) : CharClassMap() {
+  if (minCodePoint > Lexer::MAX_CHAR_VALUE) {
+    return;
+  }
+
+  // Collect the distinct labels of all transitions which match input. Epsilon transitions and wildcards
+  // don't distinguish code points.
+  std::vector<misc::IntervalSet> sets;
+  std::unordered_multimap<size_t, size_t> setsByHash;
+  for (ATNState *state : atn.states) {
+    if (state == nullptr) {
+      continue;
+    }
+
+    for (size_t i = 0; i < state->transitions.size(); ++i) {
+      Transition *transition = state->transitions[i];
+      if (transition->isEpsilon()) {
+        continue;
+      }
+
+      misc::IntervalSet set = transition->label();
+      if (set.isEmpty()) {
+        continue;
+      }
+
+      size_t hash = set.hashCode();
+      bool known = false;
+      auto range = setsByHash.equal_range(hash);
+      for (auto iterator = range.first; iterator != range.second; ++iterator) {
+        if (sets[iterator->second] == set) {
+          known = true;
+          break;
+        }
+      }
+
+      if (!known) {
+        setsByHash.emplace(hash, sets.size());
+        sets.push_back(std::move(set));
+      }
+    }
+  }
+
+  // Each set toggles its membership bit where one of its intervals starts and right after it ends
+  // (the intervals of a set are disjoint and never adjacent). Everything is clipped to the mapped range.
+  const ssize_t first = static_cast<ssize_t>(minCodePoint);
+  const ssize_t last = static_cast<ssize_t>(Lexer::MAX_CHAR_VALUE);
+  std::vector<std::pair<size_t, size_t>> toggles;
+  for (size_t i = 0; i < sets.size(); ++i) {
+    for (const misc::Interval &interval : sets[i].getIntervals()) {
+      if (interval.b < first || interval.a > last) {
+        continue;
+      }
+
+      toggles.push_back({ static_cast<size_t>(std::max(interval.a, first)), i });
+      if (interval.b < last) {
+        toggles.push_back({ static_cast<size_t>(interval.b + 1), i });
+      }
+    }
+  }
+  std::sort(toggles.begin(), toggles.end());
+
+  // Sweep over the code points. Between two toggle positions the set membership doesn't change, so all
+  // code points there are in the same class. Classes are numbered in order of their first code point.
+  // Each run is recorded by its start and class.
+  std::vector<std::pair<size_t, uint16_t>> runs;
+  std::map<std::vector<uint64_t>, size_t> classBySignature;
+  std::vector<uint64_t> signature((sets.size() + 63) / 64);
+  size_t next = 0;
+  size_t start = minCodePoint;
+  while (start <= Lexer::MAX_CHAR_VALUE) {
+    while (next < toggles.size() && toggles[next].first == start) {
+      signature[toggles[next].second / 64] ^= uint64_t(1) << (toggles[next].second % 64);
+      ++next;
+    }
+
+    auto iterator = classBySignature.find(signature);
+    if (iterator == classBySignature.end()) {
+      if (classBySignature.size() > std::numeric_limits<uint16_t>::max()) {
+        return; // Too many classes, leave the map empty.
+      }
+      iterator = classBySignature.emplace(signature, classBySignature.size()).first;
+    }
+    runs.push_back({ start, static_cast<uint16_t>(iterator->second) });
+
+    start = (next < toggles.size()) ? toggles[next].first : Lexer::MAX_CHAR_VALUE + 1;
+  }
+
+  // Fill the blocks and store each distinct block only once.
+  // Code points below minCodePoint are never looked up, they share the entries of the first class.
+  std::map<std::vector<uint16_t>, uint32_t> blockOffsets;
+  std::vector<uint16_t> block(BLOCK_SIZE);
+  size_t run = 0;
+  _index.reserve((Lexer::MAX_CHAR_VALUE + 1) / BLOCK_SIZE);
+  for (size_t offset = 0; offset <= Lexer::MAX_CHAR_VALUE; offset += BLOCK_SIZE) {
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+      while (run + 1 < runs.size() && runs[run + 1].first <= offset + i) {
+        ++run;
+      }
+      block[i] = runs[run].second;
+    }
+
+    auto iterator = blockOffsets.find(block);
+    if (iterator == blockOffsets.end()) {
+      iterator = blockOffsets.emplace(block, static_cast<uint32_t>(_blocks.size())).first;
+      _blocks.insert(_blocks.end(), block.begin(), block.end());
+    }
+    _index.push_back(iterator->second);
+  }
+
+  _size = classBySignature.size();
+  _minCodePoint = minCodePoint;
+}
@@ -0,0 +1,67 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#pragma once
+
+#include "antlr4-common.h"
+
+namespace antlr4 {
+namespace atn {
+
+  /// Partitions the code points 0..Lexer::MAX_CHAR_VALUE into equivalence classes. Two code points are in the same
+  /// class if every transition of a lexer ATN matches either both of them or none, so the lexer can share a single
+  /// DFA edge between all code points of a class. Even grammars with large Unicode sets usually need no more than
+  /// a few hundred classes.
+  ///
+  /// The class numbers are kept in a two-level table: the upper bits of a code point select a block of 256 entries,
+  /// the lowest 8 bits the entry within that block. Identical blocks are stored only once, which keeps the table
+  /// small although it covers all of Unicode.
+  class ANTLR4CPP_PUBLIC CharClassMap {
+  public:
+    /// Creates an empty map, which maps every code point to INVALID_INDEX.
+    CharClassMap();
+
+    /// Computes the classes of the code points {@code minCodePoint}..Lexer::MAX_CHAR_VALUE from the labels of all
+    /// atom, range and set transitions in {@code atn}.
+    CharClassMap(const ATN &atn, size_t minCodePoint = 0);
+
+    /// Returns the class of {@code codePoint}, or INVALID_INDEX if the code point is out of range (e.g. EOF)
+    /// or the map is empty.
+    size_t getClass(size_t codePoint) const;
+
+    /// The number of classes.
+    size_t size() const;
+
+  private:
+    enum : size_t {
+      BLOCK_BITS = 8,
+      BLOCK_SIZE = 1 << BLOCK_BITS,
+    };
+
+    size_t _size;
+    size_t _minCodePoint;
+
+    /// Maps the upper bits of a code point to the offset of its block in _blocks.
+    std::vector<uint32_t> _index;
+
+    /// The deduplicated blocks of class numbers.
+    std::vector<uint16_t> _blocks;
+  };
+
+  inline size_t CharClassMap::getClass(size_t codePoint) const {
+    size_t block = codePoint >> BLOCK_BITS;
+    if (block >= _index.size() || codePoint < _minCodePoint) {
+      return INVALID_INDEX;
+    }
+
+    return _blocks[_index[block] + (codePoint & (BLOCK_SIZE - 1))];
+  }
+
+  inline size_t CharClassMap::size() const {
+    return _size;
+  }
+
+} // namespace atn
+} // namespace antlr4
@@ -6,6 +6,7 @@
 #include "atn/EmptyPredictionContext.h"
 
 using namespace antlr4::atn;
+using namespace antlrcpp;
 
 EmptyPredictionContext::EmptyPredictionContext() : SingletonPredictionContext(nullptr, EMPTY_RETURN_STATE) {
 }
@@ -18,7 +19,7 @@ size_t EmptyPredictionContext::size() const {
   return 1;
 }
 
-Ref<PredictionContext> EmptyPredictionContext::getParent(size_t /*index*/) const {
+IntrusivePtr<PredictionContext> EmptyPredictionContext::getParent(size_t /*index*/) const {
   return nullptr;
 }
 
@@ -27,10 +27,19 @@
 #define DEBUG_ATN 0
 #define DEBUG_DFA 0
 
+// Build the runtime with e.g. -DANTLR4CPP_LEXER_MAX_DFA_EDGE=255 (or the ANTLR4_LEXER_MAX_DFA_EDGE CMake variable) to
+// also cache Latin-1 input in the direct part of the DFA edge tables, at the cost of larger tables. Only this file uses
+// the macro, so code compiled against the runtime headers works with any value.
+#ifndef ANTLR4CPP_LEXER_MAX_DFA_EDGE
+  #define ANTLR4CPP_LEXER_MAX_DFA_EDGE 127
+#endif
+
 using namespace antlr4;
 using namespace antlr4::atn;
 using namespace antlrcpp;
 
+const size_t LexerATNSimulator::MAX_DFA_EDGE = ANTLR4CPP_LEXER_MAX_DFA_EDGE;
+
 LexerATNSimulator::SimState::~SimState() {
 }
 
@@ -57,7 +66,8 @@ LexerATNSimulator::LexerATNSimulator(const ATN &atn, std::vector<dfa::DFA> &deci
 
 LexerATNSimulator::LexerATNSimulator(Lexer *recog, const ATN &atn, std::vector<dfa::DFA> &decisionToDFA,
                                      PredictionContextCache &sharedContextCache)
-  : ATNSimulator(atn, sharedContextCache), _recog(recog), _decisionToDFA(decisionToDFA) {
+  : ATNSimulator(atn, sharedContextCache), _recog(recog), _decisionToDFA(decisionToDFA),
+    _charClasses(atn.charClasses) {
   InitializeInstanceFields();
 }
 
@@ -80,10 +90,11 @@ size_t LexerATNSimulator::match(CharStream *input, size_t mode) {
   _startIndex = input->index();
   _prevAccept.reset();
   const dfa::DFA &dfa = _decisionToDFA[mode];
-  if (dfa.s0 == nullptr) {
+  dfa::DFAState *s0 = dfa.s0.load(std::memory_order_acquire);
+  if (s0 == nullptr) {
     return matchATN(input);
   } else {
-    return execATN(input, dfa.s0);
+    return execATN(input, s0);
   }
 }
 
@@ -113,7 +124,7 @@ size_t LexerATNSimulator::matchATN(CharStream *input) {
 
   dfa::DFAState *next = addDFAState(s0_closure.release());
   if (!suppressEdge) {
-    _decisionToDFA[_mode].s0 = next;
+    _decisionToDFA[_mode].s0.store(next, std::memory_order_release);
   }
 
   size_t predict = execATN(input, next);
@@ -153,6 +164,11 @@ size_t LexerATNSimulator::execATN(CharStream *input, dfa::DFAState *ds0) {
     if (target == nullptr) {
       target = computeTargetState(input, s, t);
     }
+#if DEBUG_ATN == 1
+    else {
+      std::cout << std::string("reuse state ") << s->stateNumber << std::string(" edge to ") << target->stateNumber << std::endl;
+    }
+#endif
 
     if (target == ERROR.get()) {
       break;
@@ -180,24 +196,6 @@ size_t LexerATNSimulator::execATN(CharStream *input, dfa::DFAState *ds0) {
   return failOrAccept(input, s->configs.get(), t);
 }
 
-dfa::DFAState *LexerATNSimulator::getExistingTargetState(dfa::DFAState *s, size_t t) {
-  dfa::DFAState* retval = nullptr;
-  _edgeLock.readLock();
-  if (t <= MAX_DFA_EDGE) {
-    auto iterator = s->edges.find(t - MIN_DFA_EDGE);
-#if DEBUG_ATN == 1
-    if (iterator != s->edges.end()) {
-      std::cout << std::string("reuse state ") << s->stateNumber << std::string(" edge to ") << iterator->second->stateNumber << std::endl;
-    }
-#endif
-
-    if (iterator != s->edges.end())
-      retval = iterator->second;
-  }
-  _edgeLock.readUnlock();
-  return retval;
-}
-
 dfa::DFAState *LexerATNSimulator::computeTargetState(CharStream *input, dfa::DFAState *s, size_t t) {
   OrderedATNConfigSet *reach = new OrderedATNConfigSet(); /* mem-check: deleted on error or managed by new DFA state. */
 
@@ -302,7 +300,7 @@ atn::ATNState *LexerATNSimulator::getReachableTarget(Transition *trans, size_t t
 }
 
 std::unique_ptr<ATNConfigSet> LexerATNSimulator::computeStartState(CharStream *input, ATNState *p) {
-  Ref<PredictionContext> initialContext = PredictionContext::EMPTY; // ml: the purpose of this assignment is unclear
+  IntrusivePtr<PredictionContext> initialContext = PredictionContext::EMPTY; // ml: the purpose of this assignment is unclear
   std::unique_ptr<ATNConfigSet> configs(new OrderedATNConfigSet());
   for (size_t i = 0; i < p->transitions.size(); i++) {
     ATNState *target = p->transitions[i]->target;
@@ -341,9 +339,9 @@ bool LexerATNSimulator::closure(CharStream *input, const Ref<LexerATNConfig> &co
     if (config->context != nullptr && !config->context->isEmpty()) {
       for (size_t i = 0; i < config->context->size(); i++) {
         if (config->context->getReturnState(i) != PredictionContext::EMPTY_RETURN_STATE) {
-          std::weak_ptr<PredictionContext> newContext = config->context->getParent(i); // "pop" return state
+          IntrusivePtr<PredictionContext> newContext = config->context->getParent(i); // "pop" return state
           ATNState *returnState = atn.states[config->context->getReturnState(i)];
-          Ref<LexerATNConfig> c = std::make_shared<LexerATNConfig>(config, returnState, newContext.lock());
+          Ref<LexerATNConfig> c = std::make_shared<LexerATNConfig>(config, returnState, newContext);
           currentAltReachedAcceptState = closure(input, c, configs, currentAltReachedAcceptState, speculative, treatEofAsEpsilon);
         }
       }
@@ -378,7 +376,7 @@ Ref<LexerATNConfig> LexerATNSimulator::getEpsilonTarget(CharStream *input, const
   switch (t->getSerializationType()) {
     case Transition::RULE: {
       RuleTransition *ruleTransition = static_cast<RuleTransition*>(t);
-      Ref<PredictionContext> newContext = SingletonPredictionContext::create(config->context, ruleTransition->followState->stateNumber);
+      IntrusivePtr<PredictionContext> newContext = SingletonPredictionContext::create(config->context, ruleTransition->followState->stateNumber);
       c = std::make_shared<LexerATNConfig>(config, t->target, newContext);
       break;
     }
@@ -525,14 +523,19 @@ dfa::DFAState *LexerATNSimulator::addDFAEdge(dfa::DFAState *from, size_t t, ATNC
 }
 
 void LexerATNSimulator::addDFAEdge(dfa::DFAState *p, size_t t, dfa::DFAState *q) {
-  if (/*t < MIN_DFA_EDGE ||*/ t > MAX_DFA_EDGE) { // MIN_DFA_EDGE is 0
-    // Only track edges within the DFA bounds
+  if (t <= MAX_DFA_EDGE) { // MIN_DFA_EDGE is 0
+    p->setEdge(t - MIN_DFA_EDGE, q, MAX_DFA_EDGE - MIN_DFA_EDGE + 1); // connect
     return;
   }
 
-  _edgeLock.writeLock();
-  p->edges[t - MIN_DFA_EDGE] = q; // connect
-  _edgeLock.writeUnlock();
+  // Code points above the direct range share one edge per class, behind the direct entries. The table only grows
+  // to its full size once such an edge is added.
+  size_t charClass = _charClasses.getClass(t);
+  if (charClass == INVALID_INDEX) {
+    // Only track edges within the DFA bounds
+    return;
+  }
+  p->setEdge(MAX_DFA_EDGE - MIN_DFA_EDGE + 1 + charClass, q, MAX_DFA_EDGE - MIN_DFA_EDGE + 1 + _charClasses.size());
 }
 
 dfa::DFAState *LexerATNSimulator::addDFAState(ATNConfigSet *configs) {
@@ -558,12 +561,11 @@ dfa::DFAState *LexerATNSimulator::addDFAState(ATNConfigSet *configs) {
 
   dfa::DFA &dfa = _decisionToDFA[_mode];
 
-  _stateLock.writeLock();
+  std::unique_lock<std::mutex> lock { dfa.getStateLock() };
   if (!dfa.states.empty()) {
     auto iterator = dfa.states.find(proposed);
     if (iterator != dfa.states.end()) {
       delete proposed;
-      _stateLock.writeUnlock();
       return *iterator;
     }
   }
@@ -572,7 +574,6 @@ dfa::DFAState *LexerATNSimulator::addDFAState(ATNConfigSet *configs) {
   proposed->configs->setReadonly(true);
 
   dfa.states.insert(proposed);
-  _stateLock.writeUnlock();
 
   return proposed;
 }
@@ -602,13 +603,23 @@ void LexerATNSimulator::setCharPositionInLine(size_t charPositionInLine) {
   _charPositionInLine = charPositionInLine;
 }
 
+void LexerATNSimulator::setLineCounting(bool enabled) {
+  _countLines = enabled;
+}
+
+bool LexerATNSimulator::isLineCounting() const {
+  return _countLines;
+}
+
 void LexerATNSimulator::consume(CharStream *input) {
-  size_t curChar = input->LA(1);
-  if (curChar == '\n') {
-    _line++;
-    _charPositionInLine = 0;
-  } else {
-    _charPositionInLine++;
+  if (_countLines) {
+    size_t curChar = input->LA(1);
+    if (curChar == '\n') {
+      _line++;
+      _charPositionInLine = 0;
+    } else {
+      _charPositionInLine++;
+    }
   }
   input->consume();
 }
@@ -624,5 +635,6 @@ void LexerATNSimulator::InitializeInstanceFields() {
   _startIndex = 0;
   _line = 1;
   _charPositionInLine = 0;
+  _countLines = true;
   _mode = antlr4::Lexer::DEFAULT_MODE;
 }
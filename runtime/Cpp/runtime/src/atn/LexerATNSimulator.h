@@ -8,6 +8,8 @@
 #include "atn/ATNSimulator.h"
 #include "atn/LexerATNConfig.h"
 #include "atn/ATNConfigSet.h"
+#include "atn/CharClassMap.h"
+#include "dfa/DFAState.h"
 
 namespace antlr4 {
 namespace atn {
@@ -40,14 +42,18 @@ namespace atn {
   public:
 #if __cplusplus >= 201703L
     static constexpr size_t MIN_DFA_EDGE = 0;
-    static constexpr size_t MAX_DFA_EDGE = 127; // forces unicode to stay in ATN
 #else
     enum : size_t {
       MIN_DFA_EDGE = 0,
-      MAX_DFA_EDGE = 127, // forces unicode to stay in ATN
     };
 #endif
 
+    /// Lexer DFA states keep a dense edge table, directly indexed by the code point, for all code points up to this
+    /// value. Edges for all other code points are keyed by their equivalence class (see CharClassMap) and follow the
+    /// direct entries. The value is chosen when the runtime is built (see LexerATNSimulator.cpp), so it is no compile
+    /// time constant here and code using the runtime does not depend on it.
+    static const size_t MAX_DFA_EDGE;
+
   protected:
     /// <summary>
     /// When we hit an accept state in either the DFA or the ATN, we
@@ -79,6 +85,10 @@ namespace atn {
     /// The index of the character relative to the beginning of the line 0..n-1.
     size_t _charPositionInLine;
 
+    /// Whether consume() updates _line and _charPositionInLine. Off for a lexer which takes the positions from the
+    /// line index of its input, which saves looking at every consumed character.
+    bool _countLines;
+
   public:
     std::vector<dfa::DFA> &_decisionToDFA;
 
@@ -88,6 +98,9 @@ namespace atn {
     /// Used during DFA/ATN exec to record the most recent accept configuration info.
     SimState _prevAccept;
 
+    /// The code point classes of the ATN, for edges above MAX_DFA_EDGE.
+    const CharClassMap &_charClasses;
+
   public:
     static int match_calls;
 
@@ -115,7 +128,10 @@ namespace atn {
     /// <returns> The existing target DFA state for the given input symbol
     /// {@code t}, or {@code null} if the target state for this edge is not
     /// already cached </returns>
-    virtual dfa::DFAState *getExistingTargetState(dfa::DFAState *s, size_t t);
+    /// <remarks> This is called for every input character, so it is not virtual and the
+    /// lookup is a single bounds check plus a load from the dense edge table of {@code s}.
+    /// Code points above MAX_DFA_EDGE need an additional class lookup. </remarks>
+    dfa::DFAState *getExistingTargetState(dfa::DFAState *s, size_t t);
 
     /// <summary>
     /// Compute a target state for an edge in the DFA, and attempt to add the
@@ -206,6 +222,8 @@ namespace atn {
     virtual void setLine(size_t line);
     virtual size_t getCharPositionInLine();
     virtual void setCharPositionInLine(size_t charPositionInLine);
+    void setLineCounting(bool enabled);
+    bool isLineCounting() const;
     virtual void consume(CharStream *input);
     virtual std::string getTokenName(size_t t);
 
@@ -213,5 +231,17 @@ namespace atn {
     void InitializeInstanceFields();
   };
 
+  inline dfa::DFAState *LexerATNSimulator::getExistingTargetState(dfa::DFAState *s, size_t t) {
+    if (t <= MAX_DFA_EDGE) {
+      return s->getEdge(t - MIN_DFA_EDGE);
+    }
+
+    size_t charClass = _charClasses.getClass(t);
+    if (charClass == INVALID_INDEX) {
+      return nullptr;
+    }
+    return s->getEdge(MAX_DFA_EDGE - MIN_DFA_EDGE + 1 + charClass);
+  }
+
 } // namespace atn
 } // namespace antlr4
@@ -44,6 +44,19 @@ using namespace antlr4::atn;
 
 using namespace antlrcpp;
 
+namespace {
+
+  // Configurations are allocated in the prediction arena of the simulator. The DFA outlives the prediction,
+  // so config sets moving into it get their own copies. Otherwise a few surviving configurations
+  // would keep whole arena chunks alive.
+  void copyConfigsToHeap(ATNConfigSet *configs) {
+    for (auto &config : configs->configs) {
+      config = std::make_shared<ATNConfig>(*config);
+    }
+  }
+
+}
+
 const bool ParserATNSimulator::TURN_OFF_LR_LOOP_ENTRY_BRANCH_OPT = ParserATNSimulator::getLrLoopSetting();
 
 ParserATNSimulator::ParserATNSimulator(const ATN &atn, std::vector<dfa::DFA> &decisionToDFA,
@@ -86,11 +99,18 @@ size_t ParserATNSimulator::adaptivePredict(TokenStream *input, size_t decision,
 
   // Now we are certain to have a specific decision's DFA
   // But, do we still need an initial state?
-  auto onExit = finally([this, input, index, m] {
+  dfa.beginUse();
+  auto onExit = finally([this, &dfa, input, index, m] {
     mergeCache.clear(); // wack cache after each prediction
+    _configArena.reset();
     _dfa = nullptr;
     input->seek(index);
     input->release(m);
+
+    dfa.endUse();
+    if (_dfaMemoryLimit > 0 && _dfaMemoryAdded > _dfaMemoryLimit / 16) {
+      enforceDFAMemoryLimit();
+    }
   });
 
   dfa::DFAState *s0;
@@ -100,7 +120,7 @@ size_t ParserATNSimulator::adaptivePredict(TokenStream *input, size_t decision,
     s0 = dfa.getPrecedenceStartState(parser->getPrecedence());
   } else {
     // the start state for a "regular" DFA is just s0
-    s0 = dfa.s0;
+    s0 = dfa.s0.load(std::memory_order_acquire);
   }
 
   if (s0 == nullptr) {
@@ -108,7 +128,7 @@ size_t ParserATNSimulator::adaptivePredict(TokenStream *input, size_t decision,
     std::unique_ptr<ATNConfigSet> s0_closure = computeStartState(dynamic_cast<ATNState *>(dfa.atnStartState),
                                                                  &ParserRuleContext::EMPTY, fullCtx);
 
-    _stateLock.writeLock();
+    std::unique_lock<std::mutex> lock { dfa.getStateLock() };
     if (dfa.isPrecedenceDfa()) {
       /* If this is a precedence DFA, we use applyPrecedenceFilter
        * to convert the computed start state to a precedence start
@@ -116,10 +136,12 @@ size_t ParserATNSimulator::adaptivePredict(TokenStream *input, size_t decision,
        * appropriate start state for the precedence level rather
        * than simply setting DFA.s0.
        */
-      dfa.s0->configs = std::move(s0_closure); // not used for prediction but useful to know start configs anyway
-      dfa::DFAState *newState = new dfa::DFAState(applyPrecedenceFilter(dfa.s0->configs.get())); /* mem-check: managed by the DFA or deleted below */
+      dfa::DFAState *precedenceState = dfa.s0.load(std::memory_order_relaxed);
+      precedenceState->configs = std::move(s0_closure); // not used for prediction but useful to know start configs anyway
+      copyConfigsToHeap(precedenceState->configs.get());
+      dfa::DFAState *newState = new dfa::DFAState(applyPrecedenceFilter(precedenceState->configs.get())); /* mem-check: managed by the DFA or deleted below */
       s0 = addDFAState(dfa, newState);
-      dfa.setPrecedenceStartState(parser->getPrecedence(), s0, _edgeLock);
+      dfa.setPrecedenceStartState(parser->getPrecedence(), s0);
       if (s0 != newState) {
         delete newState; // If there was already a state with this config set we don't need the new one.
       }
@@ -127,15 +149,15 @@ size_t ParserATNSimulator::adaptivePredict(TokenStream *input, size_t decision,
       dfa::DFAState *newState = new dfa::DFAState(std::move(s0_closure)); /* mem-check: managed by the DFA or deleted below */
       s0 = addDFAState(dfa, newState);
 
-      if (dfa.s0 != s0) {
-        delete dfa.s0; // Delete existing s0 DFA state, if there's any.
-        dfa.s0 = s0;
+      dfa::DFAState *previous = dfa.s0.load(std::memory_order_relaxed);
+      if (previous != s0) {
+        dfa.s0.store(s0, std::memory_order_release);
+        delete previous; // Delete existing s0 DFA state, if there's any.
       }
       if (s0 != newState) {
         delete newState; // If there was already a state with this config set we don't need the new one.
       }
     }
-    _stateLock.writeUnlock();
   }
 
   // We can start with an existing DFA.
@@ -259,12 +281,7 @@ size_t ParserATNSimulator::execATN(dfa::DFA &dfa, dfa::DFAState *s0, TokenStream
 }
 
 dfa::DFAState *ParserATNSimulator::getExistingTargetState(dfa::DFAState *previousD, size_t t) {
-  dfa::DFAState* retval;
-  _edgeLock.readLock();
-  auto iterator = previousD->edges.find(t);
-  retval = (iterator == previousD->edges.end()) ? nullptr : iterator->second;
-  _edgeLock.readUnlock();
-  return retval;
+  return previousD->getEdge(t + 1); // Shift by 1 so that EOF maps to edge 0.
 }
 
 dfa::DFAState *ParserATNSimulator::computeTargetState(dfa::DFA &dfa, dfa::DFAState *previousD, size_t t) {
@@ -468,7 +485,7 @@ std::unique_ptr<ATNConfigSet> ParserATNSimulator::computeReachSet(ATNConfigSet *
       Transition *trans = c->state->transitions[ti];
       ATNState *target = getReachableTarget(trans, (int)t);
       if (target != nullptr) {
-        intermediate->add(std::make_shared<ATNConfig>(c, target), &mergeCache);
+        intermediate->add(createConfig(c, target), &mergeCache);
       }
     }
   }
@@ -575,7 +592,7 @@ ATNConfigSet* ParserATNSimulator::removeAllConfigsNotInRuleStopState(ATNConfigSe
       misc::IntervalSet nextTokens = atn.nextTokens(config->state);
       if (nextTokens.contains(Token::EPSILON)) {
         ATNState *endOfRuleState = atn.ruleToStopState[config->state->ruleIndex];
-        result->add(std::make_shared<ATNConfig>(config, endOfRuleState), &mergeCache);
+        result->add(createConfig(config, endOfRuleState), &mergeCache);
       }
     }
   }
@@ -585,12 +602,12 @@ ATNConfigSet* ParserATNSimulator::removeAllConfigsNotInRuleStopState(ATNConfigSe
 
 std::unique_ptr<ATNConfigSet> ParserATNSimulator::computeStartState(ATNState *p, RuleContext *ctx, bool fullCtx) {
   // always at least the implicit call to start rule
-  Ref<PredictionContext> initialContext = PredictionContext::fromRuleContext(atn, ctx);
+  IntrusivePtr<PredictionContext> initialContext = PredictionContext::fromRuleContext(atn, ctx);
   std::unique_ptr<ATNConfigSet> configs(new ATNConfigSet(fullCtx));
 
   for (size_t i = 0; i < p->transitions.size(); i++) {
     ATNState *target = p->transitions[i]->target;
-    Ref<ATNConfig> c = std::make_shared<ATNConfig>(target, (int)i + 1, initialContext);
+    Ref<ATNConfig> c = createConfig(target, (int)i + 1, initialContext);
     ATNConfig::Set closureBusy;
     closure(c, configs.get(), closureBusy, true, fullCtx, false);
   }
@@ -599,7 +616,7 @@ std::unique_ptr<ATNConfigSet> ParserATNSimulator::computeStartState(ATNState *p,
 }
 
 std::unique_ptr<ATNConfigSet> ParserATNSimulator::applyPrecedenceFilter(ATNConfigSet *configs) {
-  std::map<size_t, Ref<PredictionContext>> statesFromAlt1;
+  std::map<size_t, IntrusivePtr<PredictionContext>> statesFromAlt1;
   std::unique_ptr<ATNConfigSet> configSet(new ATNConfigSet(configs->fullCtx));
   for (Ref<ATNConfig> &config : configs->configs) {
     // handle alt 1 first
@@ -615,7 +632,7 @@ std::unique_ptr<ATNConfigSet> ParserATNSimulator::applyPrecedenceFilter(ATNConfi
 
     statesFromAlt1[config->state->stateNumber] = config->context;
     if (updatedContext != config->semanticContext) {
-      configSet->add(std::make_shared<ATNConfig>(config, updatedContext), &mergeCache);
+      configSet->add(createConfig(config, updatedContext), &mergeCache);
     }
     else {
       configSet->add(config, &mergeCache);
@@ -831,7 +848,7 @@ void ParserATNSimulator::closureCheckingStopState(Ref<ATNConfig> const& config,
       for (size_t i = 0; i < config->context->size(); i++) {
         if (config->context->getReturnState(i) == PredictionContext::EMPTY_RETURN_STATE) {
           if (fullCtx) {
-            configs->add(std::make_shared<ATNConfig>(config, config->state, PredictionContext::EMPTY), &mergeCache);
+            configs->add(createConfig(config, config->state, PredictionContext::EMPTY), &mergeCache);
             continue;
           } else {
             // we have no context info, just chase follow links (if greedy)
@@ -843,8 +860,8 @@ void ParserATNSimulator::closureCheckingStopState(Ref<ATNConfig> const& config,
           continue;
         }
         ATNState *returnState = atn.states[config->context->getReturnState(i)];
-        std::weak_ptr<PredictionContext> newContext = config->context->getParent(i); // "pop" return state
-        Ref<ATNConfig> c = std::make_shared<ATNConfig>(returnState, config->alt, newContext.lock(), config->semanticContext);
+        IntrusivePtr<PredictionContext> newContext = config->context->getParent(i); // "pop" return state
+        Ref<ATNConfig> c = createConfig(returnState, config->alt, newContext, config->semanticContext);
         // While we have context to pop back from, we may have
         // gotten that context AFTER having falling off a rule.
         // Make sure we track that we are now out of context.
@@ -1052,7 +1069,7 @@ Ref<ATNConfig> ParserATNSimulator::getEpsilonTarget(Ref<ATNConfig> const& config
       return actionTransition(config, static_cast<ActionTransition*>(t));
 
     case Transition::EPSILON:
-      return std::make_shared<ATNConfig>(config, t->target);
+      return createConfig(config, t->target);
 
     case Transition::ATOM:
     case Transition::RANGE:
@@ -1061,7 +1078,7 @@ Ref<ATNConfig> ParserATNSimulator::getEpsilonTarget(Ref<ATNConfig> const& config
       // transition is traversed
       if (treatEofAsEpsilon) {
         if (t->matches(Token::EOF, 0, 1)) {
-          return std::make_shared<ATNConfig>(config, t->target);
+          return createConfig(config, t->target);
         }
       }
 
@@ -1077,7 +1094,7 @@ Ref<ATNConfig> ParserATNSimulator::actionTransition(Ref<ATNConfig> const& config
     std::cout << "ACTION edge " << t->ruleIndex << ":" << t->actionIndex << std::endl;
 #endif
 
-  return std::make_shared<ATNConfig>(config, t->target);
+  return createConfig(config, t->target);
 }
 
 Ref<ATNConfig> ParserATNSimulator::precedenceTransition(Ref<ATNConfig> const& config, PrecedencePredicateTransition *pt,
@@ -1103,14 +1120,14 @@ Ref<ATNConfig> ParserATNSimulator::precedenceTransition(Ref<ATNConfig> const& co
       bool predSucceeds = evalSemanticContext(pt->getPredicate(), _outerContext, config->alt, fullCtx);
       _input->seek(currentPosition);
       if (predSucceeds) {
-        c = std::make_shared<ATNConfig>(config, pt->target); // no pred context
+        c = createConfig(config, pt->target); // no pred context
       }
     } else {
       Ref<SemanticContext> newSemCtx = SemanticContext::And(config->semanticContext, predicate);
-      c = std::make_shared<ATNConfig>(config, pt->target, newSemCtx);
+      c = createConfig(config, pt->target, newSemCtx);
     }
   } else {
-    c = std::make_shared<ATNConfig>(config, pt->target);
+    c = createConfig(config, pt->target);
   }
 
 #if DEBUG_DFA == 1
@@ -1142,14 +1159,14 @@ Ref<ATNConfig> ParserATNSimulator::predTransition(Ref<ATNConfig> const& config,
       bool predSucceeds = evalSemanticContext(pt->getPredicate(), _outerContext, config->alt, fullCtx);
       _input->seek(currentPosition);
       if (predSucceeds) {
-        c = std::make_shared<ATNConfig>(config, pt->target); // no pred context
+        c = createConfig(config, pt->target); // no pred context
       }
     } else {
       Ref<SemanticContext> newSemCtx = SemanticContext::And(config->semanticContext, predicate);
-      c = std::make_shared<ATNConfig>(config, pt->target, newSemCtx);
+      c = createConfig(config, pt->target, newSemCtx);
     }
   } else {
-    c = std::make_shared<ATNConfig>(config, pt->target);
+    c = createConfig(config, pt->target);
   }
 
 #if DEBUG_DFA == 1
@@ -1165,8 +1182,8 @@ Ref<ATNConfig> ParserATNSimulator::ruleTransition(Ref<ATNConfig> const& config,
 #endif
 
   atn::ATNState *returnState = t->followState;
-  Ref<PredictionContext> newContext = SingletonPredictionContext::create(config->context, returnState->stateNumber);
-  return std::make_shared<ATNConfig>(config, t->target, newContext);
+  IntrusivePtr<PredictionContext> newContext = SingletonPredictionContext::create(config->context, returnState->stateNumber);
+  return createConfig(config, t->target, newContext);
 }
 
 BitSet ParserATNSimulator::getConflictingAlts(ATNConfigSet *configs) {
@@ -1249,18 +1266,15 @@ dfa::DFAState *ParserATNSimulator::addDFAEdge(dfa::DFA &dfa, dfa::DFAState *from
     return nullptr;
   }
 
-  _stateLock.writeLock();
-  to = addDFAState(dfa, to); // used existing if possible not incoming
-  _stateLock.writeUnlock();
+  {
+    std::unique_lock<std::mutex> lock { dfa.getStateLock() };
+    to = addDFAState(dfa, to); // used existing if possible not incoming
+  }
   if (from == nullptr || t > (int)atn.maxTokenType) {
     return to;
   }
 
-  {
-    _edgeLock.writeLock();
-    from->edges[t] = to; // connect
-    _edgeLock.writeUnlock();
-  }
+  from->setEdge(static_cast<size_t>(t + 1), to, atn.maxTokenType + 2); // connect
 
 #if DEBUG_DFA == 1
     std::string dfaText;
@@ -1290,6 +1304,11 @@ dfa::DFAState *ParserATNSimulator::addDFAState(dfa::DFA &dfa, dfa::DFAState *D)
     D->configs->optimizeConfigs(this);
     D->configs->setReadonly(true);
   }
+  copyConfigsToHeap(D->configs.get());
+
+  size_t memoryUsage = estimateDFAStateMemory(atn, D);
+  dfa.addMemoryUsage(memoryUsage);
+  _dfaMemoryAdded += memoryUsage;
 
   dfa.states.insert(D);
 
@@ -1344,6 +1363,63 @@ atn::PredictionMode ParserATNSimulator::getPredictionMode() {
   return _mode;
 }
 
+void ParserATNSimulator::setDFAMemoryLimit(size_t bytes) {
+  _dfaMemoryLimit = bytes;
+}
+
+size_t ParserATNSimulator::getDFAMemoryLimit() const {
+  return _dfaMemoryLimit;
+}
+
+size_t ParserATNSimulator::estimateDFAStateMemory(const ATN &atn, const dfa::DFAState *state) {
+  // The edge table of a parser DFA state has room for all tokens, see addDFAEdge().
+  return sizeof(dfa::DFAState) + (atn.maxTokenType + 2) * sizeof(dfa::DFAState *) +
+    state->configs->size() * (sizeof(ATNConfig) + 4 * sizeof(void *));
+}
+
+void ParserATNSimulator::enforceDFAMemoryLimit() {
+  _dfaMemoryAdded = 0;
+  dfa::DFA::advanceUseClock();
+
+  // The use time and size are sampled once, since other threads keep changing them while we sort.
+  struct Candidate {
+    dfa::DFA *dfa;
+    size_t lastUse;
+    size_t usage;
+  };
+
+  size_t total = 0;
+  std::vector<Candidate> candidates;
+  for (auto &dfa : decisionToDFA) {
+    size_t usage = dfa.getMemoryUsage();
+    if (usage > 0) {
+      total += usage;
+      candidates.push_back({ &dfa, dfa.getLastUse(), usage });
+    }
+  }
+
+  if (total <= _dfaMemoryLimit) {
+    return;
+  }
+
+  // Clear the least recently used decisions first and, among equally old ones, the largest.
+  std::sort(candidates.begin(), candidates.end(), [](const Candidate &lhs, const Candidate &rhs) {
+    if (lhs.lastUse != rhs.lastUse) {
+      return lhs.lastUse < rhs.lastUse;
+    }
+    return lhs.usage > rhs.usage;
+  });
+
+  size_t target = _dfaMemoryLimit - _dfaMemoryLimit / 4;
+  for (auto &candidate : candidates) {
+    if (total <= target) {
+      break;
+    }
+    candidate.dfa->clearStates();
+    total -= candidate.usage;
+  }
+}
+
 Parser* ParserATNSimulator::getParser() {
   return parser;
 }
@@ -1363,4 +1439,6 @@ bool ParserATNSimulator::getLrLoopSetting() {
 void ParserATNSimulator::InitializeInstanceFields() {
   _mode = PredictionMode::LL;
   _startIndex = 0;
+  _dfaMemoryLimit = 0;
+  _dfaMemoryAdded = 0;
 }
@@ -11,6 +11,7 @@
 #include "atn/PredictionContext.h"
 #include "SemanticContext.h"
 #include "atn/ATNConfig.h"
+#include "support/Arena.h"
 
 namespace antlr4 {
 namespace atn {
@@ -169,12 +170,11 @@ namespace atn {
    * <strong>THREAD SAFETY</strong></p>
    *
    * <p>
-   * The {@link ParserATNSimulator} locks on the {@link #decisionToDFA} field when
-   * it adds a new DFA object to that array. {@link #addDFAEdge}
-   * locks on the DFA for the current decision when setting the
-   * {@link DFAState#edges} field. {@link #addDFAState} locks on
-   * the DFA for the current decision when looking up a DFA state to see if it
-   * already exists. We must make sure that all requests to add DFA states that
+   * {@link #addDFAEdge} locks on the {@link DFA#getStateLock state lock} of the
+   * DFA for the current decision when calling {@link #addDFAState}, which looks
+   * up a DFA state to see if it already exists. There is no process-wide lock, so
+   * threads warming up different decisions (or grammars) never block each other.
+   * We must make sure that all requests to add DFA states that
    * are equivalent result in the same shared DFA object. This is because lots of
    * threads will be trying to update the DFA at once. The
    * {@link #addDFAState} method also locks inside the DFA lock
@@ -184,13 +184,13 @@ namespace atn {
    * safe as long as we can guarantee that all threads referencing
    * {@code s.edge[t]} get the same physical target {@link DFAState}, or
    * {@code null}. Once into the DFA, the DFA simulation does not reference the
-   * {@link DFA#states} map. It follows the {@link DFAState#edges} field to new
-   * targets. The DFA simulator will either find {@link DFAState#edges} to be
-   * {@code null}, to be non-{@code null} and {@code dfa.edges[t]} null, or
-   * {@code dfa.edges[t]} to be non-null. The
-   * {@link #addDFAEdge} method could be racing to set the field
+   * {@link DFA#states} map. It follows the {@link DFAState#getEdge edges} to new
+   * targets. Edge tables are published with atomic pointers, so the DFA simulator
+   * will either find no edge table, a table with {@code edges[t]} null, or
+   * {@code edges[t]} pointing to a fully constructed target state. The
+   * {@link #addDFAEdge} method could be racing to set the edge
    * but in either case the DFA simulator works; if {@code null}, and requests ATN
-   * simulation. It could also race trying to get {@code dfa.edges[t]}, but either
+   * simulation. It could also race trying to get {@code edges[t]}, but either
    * way it will work because it's not doing a test and set operation.</p>
    *
    * <p>
@@ -354,6 +354,16 @@ namespace atn {
     void setPredictionMode(PredictionMode newMode);
     PredictionMode getPredictionMode();
 
+    /// Limits the estimated memory used by the DFA states of all decisions in decisionToDFA, in bytes. 0 (the default)
+    /// means unlimited. When the DFA grows beyond the limit, the least recently used decisions are cleared until it
+    /// is at three quarters of the limit, and rebuilt on demand. This is safe while other parsers sharing the DFA
+    /// predict. The limit is a setting of this simulator, so set it on all simulators which share decisionToDFA.
+    void setDFAMemoryLimit(size_t bytes);
+    size_t getDFAMemoryLimit() const;
+
+    /// The estimated memory used by a state of a parser DFA for {@code atn}, as counted for the DFA memory limit.
+    static size_t estimateDFAStateMemory(const ATN &atn, const dfa::DFAState *state);
+
     Parser* getParser();
     
     virtual std::string getTokenName(size_t t);
@@ -386,6 +396,15 @@ namespace atn {
     size_t _startIndex;
     ParserRuleContext *_outerContext;
     dfa::DFA *_dfa; // Reference into the decisionToDFA vector.
+
+    /// The configurations computed during a prediction are allocated from this arena, which is reset when the
+    /// prediction ends. Configurations which make it into the DFA are copied to the heap by addDFAState.
+    antlrcpp::Arena _configArena;
+
+    template <typename... Args>
+    Ref<ATNConfig> createConfig(Args&&... args) {
+      return std::allocate_shared<ATNConfig>(antlrcpp::ArenaAllocator<ATNConfig>(_configArena), std::forward<Args>(args)...);
+    }
     
     /// <summary>
     /// Performs ATN simulation to compute a predicted alternative based
@@ -869,6 +888,8 @@ namespace atn {
     /// <p/>
     /// If {@code D} is <seealso cref="#ERROR"/>, this method returns <seealso cref="#ERROR"/> and
     /// does not change the DFA.
+    /// <p/>
+    /// The caller must hold the state lock of {@code dfa}.
     /// </summary>
     /// <param name="dfa"> The dfa </param>
     /// <param name="D"> The DFA state to add </param>
@@ -891,10 +912,18 @@ namespace atn {
                                  const antlrcpp::BitSet &ambigAlts,
                                  ATNConfigSet *configs); // configs that LL not SLL considered conflicting
 
+    /// Clears least recently used decisions until the DFA is within the memory limit.
+    virtual void enforceDFAMemoryLimit();
+
   private:
     // SLL, LL, or LL + exact ambig detection?
     PredictionMode _mode;
 
+    size_t _dfaMemoryLimit;
+
+    /// The estimated memory of the DFA states added by this simulator since the last limit check.
+    size_t _dfaMemoryAdded;
+
     static bool getLrLoopSetting();
     void InitializeInstanceFields();
   };
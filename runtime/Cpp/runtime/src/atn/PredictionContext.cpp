@@ -21,7 +21,7 @@ using namespace antlr4::atn;
 using namespace antlrcpp;
 
 size_t PredictionContext::globalNodeCount = 0;
-const Ref<PredictionContext> PredictionContext::EMPTY = std::make_shared<EmptyPredictionContext>();
+const IntrusivePtr<PredictionContext> PredictionContext::EMPTY = makeIntrusive<EmptyPredictionContext>();
 
 //----------------- PredictionContext ----------------------------------------------------------------------------------
 
@@ -31,7 +31,7 @@ PredictionContext::PredictionContext(size_t cachedHashCode) : id(globalNodeCount
 PredictionContext::~PredictionContext() {
 }
 
-Ref<PredictionContext> PredictionContext::fromRuleContext(const ATN &atn, RuleContext *outerContext) {
+IntrusivePtr<PredictionContext> PredictionContext::fromRuleContext(const ATN &atn, RuleContext *outerContext) {
   if (outerContext == nullptr) {
     return PredictionContext::EMPTY;
   }
@@ -43,7 +43,7 @@ Ref<PredictionContext> PredictionContext::fromRuleContext(const ATN &atn, RuleCo
   }
 
   // If we have a parent, convert it to a PredictionContext graph
-  Ref<PredictionContext> parent = PredictionContext::fromRuleContext(atn, dynamic_cast<RuleContext *>(outerContext->parent));
+  IntrusivePtr<PredictionContext> parent = PredictionContext::fromRuleContext(atn, dynamic_cast<RuleContext *>(outerContext->parent));
 
   ATNState *state = atn.states.at(outerContext->invokingState);
   RuleTransition *transition = (RuleTransition *)state->transitions[0];
@@ -69,20 +69,20 @@ size_t PredictionContext::calculateEmptyHashCode() {
   return hash;
 }
 
-size_t PredictionContext::calculateHashCode(Ref<PredictionContext> parent, size_t returnState) {
+size_t PredictionContext::calculateHashCode(IntrusivePtr<PredictionContext> parent, size_t returnState) {
   size_t hash = MurmurHash::initialize(INITIAL_HASH);
-  hash = MurmurHash::update(hash, parent);
+  hash = MurmurHash::update(hash, parent.get());
   hash = MurmurHash::update(hash, returnState);
   hash = MurmurHash::finish(hash, 2);
   return hash;
 }
 
-size_t PredictionContext::calculateHashCode(const std::vector<Ref<PredictionContext>> &parents,
+size_t PredictionContext::calculateHashCode(const std::vector<IntrusivePtr<PredictionContext>> &parents,
                                             const std::vector<size_t> &returnStates) {
   size_t hash = MurmurHash::initialize(INITIAL_HASH);
 
   for (auto parent : parents) {
-    hash = MurmurHash::update(hash, parent);
+    hash = MurmurHash::update(hash, parent.get());
   }
 
   for (auto returnState : returnStates) {
@@ -92,8 +92,8 @@ size_t PredictionContext::calculateHashCode(const std::vector<Ref<PredictionCont
   return MurmurHash::finish(hash, parents.size() + returnStates.size());
 }
 
-Ref<PredictionContext> PredictionContext::merge(const Ref<PredictionContext> &a,
-  const Ref<PredictionContext> &b, bool rootIsWildcard, PredictionContextMergeCache *mergeCache) {
+IntrusivePtr<PredictionContext> PredictionContext::merge(const IntrusivePtr<PredictionContext> &a,
+  const IntrusivePtr<PredictionContext> &b, bool rootIsWildcard, PredictionContextMergeCache *mergeCache) {
   assert(a && b);
 
   // share same graph if both same
@@ -102,8 +102,8 @@ Ref<PredictionContext> PredictionContext::merge(const Ref<PredictionContext> &a,
   }
 
   if (is<SingletonPredictionContext>(a) && is<SingletonPredictionContext>(b)) {
-    return mergeSingletons(std::dynamic_pointer_cast<SingletonPredictionContext>(a),
-                           std::dynamic_pointer_cast<SingletonPredictionContext>(b), rootIsWildcard, mergeCache);
+    return mergeSingletons(dynamic_pointer_cast<SingletonPredictionContext>(a),
+                           dynamic_pointer_cast<SingletonPredictionContext>(b), rootIsWildcard, mergeCache);
   }
 
   // At least one of a or b is array.
@@ -118,23 +118,23 @@ Ref<PredictionContext> PredictionContext::merge(const Ref<PredictionContext> &a,
   }
 
   // convert singleton so both are arrays to normalize
-  Ref<ArrayPredictionContext> left;
+  IntrusivePtr<ArrayPredictionContext> left;
   if (is<SingletonPredictionContext>(a)) {
-    left = std::make_shared<ArrayPredictionContext>(std::dynamic_pointer_cast<SingletonPredictionContext>(a));
+    left = makeIntrusive<ArrayPredictionContext>(dynamic_pointer_cast<SingletonPredictionContext>(a));
   } else {
-    left = std::dynamic_pointer_cast<ArrayPredictionContext>(a);
+    left = dynamic_pointer_cast<ArrayPredictionContext>(a);
   }
-  Ref<ArrayPredictionContext> right;
+  IntrusivePtr<ArrayPredictionContext> right;
   if (is<SingletonPredictionContext>(b)) {
-    right = std::make_shared<ArrayPredictionContext>(std::dynamic_pointer_cast<SingletonPredictionContext>(b));
+    right = makeIntrusive<ArrayPredictionContext>(dynamic_pointer_cast<SingletonPredictionContext>(b));
   } else {
-    right = std::dynamic_pointer_cast<ArrayPredictionContext>(b);
+    right = dynamic_pointer_cast<ArrayPredictionContext>(b);
   }
   return mergeArrays(left, right, rootIsWildcard, mergeCache);
 }
 
-Ref<PredictionContext> PredictionContext::mergeSingletons(const Ref<SingletonPredictionContext> &a,
-  const Ref<SingletonPredictionContext> &b, bool rootIsWildcard, PredictionContextMergeCache *mergeCache) {
+IntrusivePtr<PredictionContext> PredictionContext::mergeSingletons(const IntrusivePtr<SingletonPredictionContext> &a,
+  const IntrusivePtr<SingletonPredictionContext> &b, bool rootIsWildcard, PredictionContextMergeCache *mergeCache) {
 
   if (mergeCache != nullptr) { // Can be null if not given to the ATNState from which this call originates.
     auto existing = mergeCache->get(a, b);
@@ -147,7 +147,7 @@ Ref<PredictionContext> PredictionContext::mergeSingletons(const Ref<SingletonPre
     }
   }
 
-  Ref<PredictionContext> rootMerge = mergeRoot(a, b, rootIsWildcard);
+  IntrusivePtr<PredictionContext> rootMerge = mergeRoot(a, b, rootIsWildcard);
   if (rootMerge) {
     if (mergeCache != nullptr) {
       mergeCache->put(a, b, rootMerge);
@@ -155,10 +155,10 @@ Ref<PredictionContext> PredictionContext::mergeSingletons(const Ref<SingletonPre
     return rootMerge;
   }
 
-  Ref<PredictionContext> parentA = a->parent;
-  Ref<PredictionContext> parentB = b->parent;
+  IntrusivePtr<PredictionContext> parentA = a->parent;
+  IntrusivePtr<PredictionContext> parentB = b->parent;
   if (a->returnState == b->returnState) { // a == b
-    Ref<PredictionContext> parent = merge(parentA, parentB, rootIsWildcard, mergeCache);
+    IntrusivePtr<PredictionContext> parent = merge(parentA, parentB, rootIsWildcard, mergeCache);
 
     // If parent is same as existing a or b parent or reduced to a parent, return it.
     if (parent == parentA) { // ax + bx = ax, if a=b
@@ -172,7 +172,7 @@ Ref<PredictionContext> PredictionContext::mergeSingletons(const Ref<SingletonPre
     // merge parents x and y, giving array node with x,y then remainders
     // of those graphs.  dup a, a' points at merged array
     // new joined parent so create new singleton pointing to it, a'
-    Ref<PredictionContext> a_ = SingletonPredictionContext::create(parent, a->returnState);
+    IntrusivePtr<PredictionContext> a_ = SingletonPredictionContext::create(parent, a->returnState);
     if (mergeCache != nullptr) {
       mergeCache->put(a, b, a_);
     }
@@ -180,7 +180,7 @@ Ref<PredictionContext> PredictionContext::mergeSingletons(const Ref<SingletonPre
   } else {
     // a != b payloads differ
     // see if we can collapse parents due to $+x parents if local ctx
-    Ref<PredictionContext> singleParent;
+    IntrusivePtr<PredictionContext> singleParent;
     if (a == b || (*parentA == *parentB)) { // ax + bx = [a,b]x
       singleParent = parentA;
     }
@@ -190,8 +190,8 @@ Ref<PredictionContext> PredictionContext::mergeSingletons(const Ref<SingletonPre
         payloads[0] = b->returnState;
         payloads[1] = a->returnState;
       }
-      std::vector<Ref<PredictionContext>> parents = { singleParent, singleParent };
-      Ref<PredictionContext> a_ = std::make_shared<ArrayPredictionContext>(parents, payloads);
+      std::vector<IntrusivePtr<PredictionContext>> parents = { singleParent, singleParent };
+      IntrusivePtr<PredictionContext> a_ = makeIntrusive<ArrayPredictionContext>(parents, payloads);
       if (mergeCache != nullptr) {
         mergeCache->put(a, b, a_);
       }
@@ -201,15 +201,15 @@ Ref<PredictionContext> PredictionContext::mergeSingletons(const Ref<SingletonPre
     // parents differ and can't merge them. Just pack together
     // into array; can't merge.
     // ax + by = [ax,by]
-    Ref<PredictionContext> a_;
+    IntrusivePtr<PredictionContext> a_;
     if (a->returnState > b->returnState) { // sort by payload
       std::vector<size_t> payloads = { b->returnState, a->returnState };
-      std::vector<Ref<PredictionContext>> parents = { b->parent, a->parent };
-      a_ = std::make_shared<ArrayPredictionContext>(parents, payloads);
+      std::vector<IntrusivePtr<PredictionContext>> parents = { b->parent, a->parent };
+      a_ = makeIntrusive<ArrayPredictionContext>(parents, payloads);
     } else {
       std::vector<size_t> payloads = {a->returnState, b->returnState};
-      std::vector<Ref<PredictionContext>> parents = { a->parent, b->parent };
-      a_ = std::make_shared<ArrayPredictionContext>(parents, payloads);
+      std::vector<IntrusivePtr<PredictionContext>> parents = { a->parent, b->parent };
+      a_ = makeIntrusive<ArrayPredictionContext>(parents, payloads);
     }
 
     if (mergeCache != nullptr) {
@@ -219,8 +219,8 @@ Ref<PredictionContext> PredictionContext::mergeSingletons(const Ref<SingletonPre
   }
 }
 
-Ref<PredictionContext> PredictionContext::mergeRoot(const Ref<SingletonPredictionContext> &a,
-  const Ref<SingletonPredictionContext> &b, bool rootIsWildcard) {
+IntrusivePtr<PredictionContext> PredictionContext::mergeRoot(const IntrusivePtr<SingletonPredictionContext> &a,
+  const IntrusivePtr<SingletonPredictionContext> &b, bool rootIsWildcard) {
   if (rootIsWildcard) {
     if (a == EMPTY) { // * + b = *
       return EMPTY;
@@ -234,22 +234,22 @@ Ref<PredictionContext> PredictionContext::mergeRoot(const Ref<SingletonPredictio
     }
     if (a == EMPTY) { // $ + x = [$,x]
       std::vector<size_t> payloads = { b->returnState, EMPTY_RETURN_STATE };
-      std::vector<Ref<PredictionContext>> parents = { b->parent, nullptr };
-      Ref<PredictionContext> joined = std::make_shared<ArrayPredictionContext>(parents, payloads);
+      std::vector<IntrusivePtr<PredictionContext>> parents = { b->parent, nullptr };
+      IntrusivePtr<PredictionContext> joined = makeIntrusive<ArrayPredictionContext>(parents, payloads);
       return joined;
     }
     if (b == EMPTY) { // x + $ = [$,x] ($ is always first if present)
       std::vector<size_t> payloads = { a->returnState, EMPTY_RETURN_STATE };
-      std::vector<Ref<PredictionContext>> parents = { a->parent, nullptr };
-      Ref<PredictionContext> joined = std::make_shared<ArrayPredictionContext>(parents, payloads);
+      std::vector<IntrusivePtr<PredictionContext>> parents = { a->parent, nullptr };
+      IntrusivePtr<PredictionContext> joined = makeIntrusive<ArrayPredictionContext>(parents, payloads);
       return joined;
     }
   }
   return nullptr;
 }
 
-Ref<PredictionContext> PredictionContext::mergeArrays(const Ref<ArrayPredictionContext> &a,
-  const Ref<ArrayPredictionContext> &b, bool rootIsWildcard, PredictionContextMergeCache *mergeCache) {
+IntrusivePtr<PredictionContext> PredictionContext::mergeArrays(const IntrusivePtr<ArrayPredictionContext> &a,
+  const IntrusivePtr<ArrayPredictionContext> &b, bool rootIsWildcard, PredictionContextMergeCache *mergeCache) {
 
   if (mergeCache != nullptr) {
     auto existing = mergeCache->get(a, b);
@@ -268,12 +268,12 @@ Ref<PredictionContext> PredictionContext::mergeArrays(const Ref<ArrayPredictionC
   size_t k = 0; // walks target M array
 
   std::vector<size_t> mergedReturnStates(a->returnStates.size() + b->returnStates.size());
-  std::vector<Ref<PredictionContext>> mergedParents(a->returnStates.size() + b->returnStates.size());
+  std::vector<IntrusivePtr<PredictionContext>> mergedParents(a->returnStates.size() + b->returnStates.size());
 
   // walk and merge to yield mergedParents, mergedReturnStates
   while (i < a->returnStates.size() && j < b->returnStates.size()) {
-    Ref<PredictionContext> a_parent = a->parents[i];
-    Ref<PredictionContext> b_parent = b->parents[j];
+    IntrusivePtr<PredictionContext> a_parent = a->parents[i];
+    IntrusivePtr<PredictionContext> b_parent = b->parents[j];
     if (a->returnStates[i] == b->returnStates[j]) {
       // same payload (stack tops are equal), must yield merged singleton
       size_t payload = a->returnStates[i];
@@ -285,7 +285,7 @@ Ref<PredictionContext> PredictionContext::mergeArrays(const Ref<ArrayPredictionC
         mergedReturnStates[k] = payload;
       }
       else { // ax+ay -> a'[x,y]
-        Ref<PredictionContext> mergedParent = merge(a_parent, b_parent, rootIsWildcard, mergeCache);
+        IntrusivePtr<PredictionContext> mergedParent = merge(a_parent, b_parent, rootIsWildcard, mergeCache);
         mergedParents[k] = mergedParent;
         mergedReturnStates[k] = payload;
       }
@@ -322,7 +322,7 @@ Ref<PredictionContext> PredictionContext::mergeArrays(const Ref<ArrayPredictionC
   // trim merged if we combined a few that had same stack tops
   if (k < mergedParents.size()) { // write index < last position; trim
     if (k == 1) { // for just one merged element, return singleton top
-      Ref<PredictionContext> a_ = SingletonPredictionContext::create(mergedParents[0], mergedReturnStates[0]);
+      IntrusivePtr<PredictionContext> a_ = SingletonPredictionContext::create(mergedParents[0], mergedReturnStates[0]);
       if (mergeCache != nullptr) {
         mergeCache->put(a, b, a_);
       }
@@ -332,7 +332,7 @@ Ref<PredictionContext> PredictionContext::mergeArrays(const Ref<ArrayPredictionC
     mergedReturnStates.resize(k);
   }
 
-  Ref<ArrayPredictionContext> M = std::make_shared<ArrayPredictionContext>(mergedParents, mergedReturnStates);
+  IntrusivePtr<ArrayPredictionContext> M = makeIntrusive<ArrayPredictionContext>(mergedParents, mergedReturnStates);
 
   // if we created same array as a or b, return that instead
   // TODO: track whether this is possible above during merge sort for speed
@@ -352,7 +352,7 @@ Ref<PredictionContext> PredictionContext::mergeArrays(const Ref<ArrayPredictionC
   // ml: this part differs from Java code. We have to recreate the context as the parents array is copied on creation.
   if (combineCommonParents(mergedParents)) {
     mergedReturnStates.resize(mergedParents.size());
-    M = std::make_shared<ArrayPredictionContext>(mergedParents, mergedReturnStates);
+    M = makeIntrusive<ArrayPredictionContext>(mergedParents, mergedReturnStates);
   }
 
   if (mergeCache != nullptr) {
@@ -361,11 +361,11 @@ Ref<PredictionContext> PredictionContext::mergeArrays(const Ref<ArrayPredictionC
   return M;
 }
 
-bool PredictionContext::combineCommonParents(std::vector<Ref<PredictionContext>> &parents) {
+bool PredictionContext::combineCommonParents(std::vector<IntrusivePtr<PredictionContext>> &parents) {
 
-  std::set<Ref<PredictionContext>> uniqueParents;
+  std::set<IntrusivePtr<PredictionContext>> uniqueParents;
   for (size_t p = 0; p < parents.size(); ++p) {
-    Ref<PredictionContext> parent = parents[p];
+    IntrusivePtr<PredictionContext> parent = parents[p];
     if (uniqueParents.find(parent) == uniqueParents.end()) { // don't replace
       uniqueParents.insert(parent);
     }
@@ -378,7 +378,7 @@ bool PredictionContext::combineCommonParents(std::vector<Ref<PredictionContext>>
   return true;
 }
 
-std::string PredictionContext::toDOTString(const Ref<PredictionContext> &context) {
+std::string PredictionContext::toDOTString(const IntrusivePtr<PredictionContext> &context) {
   if (context == nullptr) {
     return "";
   }
@@ -386,8 +386,8 @@ std::string PredictionContext::toDOTString(const Ref<PredictionContext> &context
   std::stringstream ss;
   ss << "digraph G {\n" << "rankdir=LR;\n";
 
-  std::vector<Ref<PredictionContext>> nodes = getAllContextNodes(context);
-  std::sort(nodes.begin(), nodes.end(), [](const Ref<PredictionContext> &o1, const Ref<PredictionContext> &o2) {
+  std::vector<IntrusivePtr<PredictionContext>> nodes = getAllContextNodes(context);
+  std::sort(nodes.begin(), nodes.end(), [](const IntrusivePtr<PredictionContext> &o1, const IntrusivePtr<PredictionContext> &o2) {
     return o1->id - o2->id;
   });
 
@@ -402,7 +402,7 @@ std::string PredictionContext::toDOTString(const Ref<PredictionContext> &context
       ss << " [label=\"" << returnState << "\"];\n";
       continue;
     }
-    Ref<ArrayPredictionContext> arr = std::static_pointer_cast<ArrayPredictionContext>(current);
+    IntrusivePtr<ArrayPredictionContext> arr = static_pointer_cast<ArrayPredictionContext>(current);
     ss << "  s" << arr->id << " [shape=box, label=\"" << "[";
     bool first = true;
     for (auto inv : arr->returnStates) {
@@ -442,8 +442,8 @@ std::string PredictionContext::toDOTString(const Ref<PredictionContext> &context
 }
 
 // The "visited" map is just a temporary structure to control the retrieval process (which is recursive).
-Ref<PredictionContext> PredictionContext::getCachedContext(const Ref<PredictionContext> &context,
-  PredictionContextCache &contextCache, std::map<Ref<PredictionContext>, Ref<PredictionContext>> &visited) {
+IntrusivePtr<PredictionContext> PredictionContext::getCachedContext(const IntrusivePtr<PredictionContext> &context,
+  PredictionContextCache &contextCache, std::map<IntrusivePtr<PredictionContext>, IntrusivePtr<PredictionContext>> &visited) {
   if (context->isEmpty()) {
     return context;
   }
@@ -454,18 +454,18 @@ Ref<PredictionContext> PredictionContext::getCachedContext(const Ref<PredictionC
       return iterator->second; // Not necessarly the same as context.
   }
 
-  auto iterator = contextCache.find(context);
-  if (iterator != contextCache.end()) {
-    visited[context] = *iterator;
+  IntrusivePtr<PredictionContext> cached = contextCache.get(context);
+  if (cached != nullptr) {
+    visited[context] = cached;
 
-    return *iterator;
+    return cached;
   }
 
   bool changed = false;
 
-  std::vector<Ref<PredictionContext>> parents(context->size());
+  std::vector<IntrusivePtr<PredictionContext>> parents(context->size());
   for (size_t i = 0; i < parents.size(); i++) {
-    Ref<PredictionContext> parent = getCachedContext(context->getParent(i), contextCache, visited);
+    IntrusivePtr<PredictionContext> parent = getCachedContext(context->getParent(i), contextCache, visited);
     if (changed || parent != context->getParent(i)) {
       if (!changed) {
         parents.clear();
@@ -481,21 +481,20 @@ Ref<PredictionContext> PredictionContext::getCachedContext(const Ref<PredictionC
   }
 
   if (!changed) {
-    contextCache.insert(context);
-    visited[context] = context;
+    cached = contextCache.add(context);
+    visited[context] = cached;
 
-    return context;
+    return cached;
   }
 
-  Ref<PredictionContext> updated;
+  IntrusivePtr<PredictionContext> updated;
   if (parents.empty()) {
     updated = EMPTY;
   } else if (parents.size() == 1) {
-    updated = SingletonPredictionContext::create(parents[0], context->getReturnState(0));
-    contextCache.insert(updated);
+    updated = contextCache.add(SingletonPredictionContext::create(parents[0], context->getReturnState(0)));
   } else {
-    updated = std::make_shared<ArrayPredictionContext>(parents, std::dynamic_pointer_cast<ArrayPredictionContext>(context)->returnStates);
-    contextCache.insert(updated);
+    updated = contextCache.add(makeIntrusive<ArrayPredictionContext>(parents,
+      dynamic_pointer_cast<ArrayPredictionContext>(context)->returnStates));
   }
 
   visited[updated] = updated;
@@ -504,15 +503,15 @@ Ref<PredictionContext> PredictionContext::getCachedContext(const Ref<PredictionC
   return updated;
 }
 
-std::vector<Ref<PredictionContext>> PredictionContext::getAllContextNodes(const Ref<PredictionContext> &context) {
-  std::vector<Ref<PredictionContext>> nodes;
+std::vector<IntrusivePtr<PredictionContext>> PredictionContext::getAllContextNodes(const IntrusivePtr<PredictionContext> &context) {
+  std::vector<IntrusivePtr<PredictionContext>> nodes;
   std::set<PredictionContext *> visited;
   getAllContextNodes_(context, nodes, visited);
   return nodes;
 }
 
 
-void PredictionContext::getAllContextNodes_(const Ref<PredictionContext> &context, std::vector<Ref<PredictionContext>> &nodes,
+void PredictionContext::getAllContextNodes_(const IntrusivePtr<PredictionContext> &context, std::vector<IntrusivePtr<PredictionContext>> &nodes,
   std::set<PredictionContext *> &visited) {
 
   if (visited.find(context.get()) != visited.end()) {
@@ -540,7 +539,7 @@ std::vector<std::string> PredictionContext::toStrings(Recognizer *recognizer, in
   return toStrings(recognizer, EMPTY, currentState);
 }
 
-std::vector<std::string> PredictionContext::toStrings(Recognizer *recognizer, const Ref<PredictionContext> &stop, int currentState) {
+std::vector<std::string> PredictionContext::toStrings(Recognizer *recognizer, const IntrusivePtr<PredictionContext> &stop, int currentState) {
 
   std::vector<std::string> result;
 
@@ -609,11 +608,134 @@ std::vector<std::string> PredictionContext::toStrings(Recognizer *recognizer, co
   return result;
 }
 
+//----------------- PredictionContextCache -----------------------------------------------------------------------------
+
+namespace {
+
+  // An estimate of the memory used by a context in the cache, including the hash set node.
+  size_t estimateMemoryUsage(PredictionContext const& context) {
+    size_t result = 3 * sizeof(void *);
+    if (is<const ArrayPredictionContext *>(&context)) {
+      result += sizeof(ArrayPredictionContext) + context.size() * (sizeof(IntrusivePtr<PredictionContext>) + sizeof(size_t));
+    } else {
+      result += sizeof(SingletonPredictionContext);
+    }
+    return result;
+  }
+
+}
+
+PredictionContextCache::PredictionContextCache(size_t memoryLimit)
+  : _memoryLimit(memoryLimit), _hits(0), _misses(0), _evictions(0) {
+}
+
+IntrusivePtr<PredictionContext> PredictionContextCache::get(IntrusivePtr<PredictionContext> const& context) const {
+  Shard &shard = getShard(*context);
+  std::unique_lock<std::mutex> lock { shard.mutex };
+  auto iterator = shard.data.find(context);
+  if (iterator == shard.data.end()) {
+    _misses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  _hits.fetch_add(1, std::memory_order_relaxed);
+  return *iterator;
+}
+
+IntrusivePtr<PredictionContext> PredictionContextCache::add(IntrusivePtr<PredictionContext> const& context) {
+  Shard &shard = getShard(*context);
+  std::unique_lock<std::mutex> lock { shard.mutex };
+  auto result = shard.data.insert(context);
+  if (!result.second) {
+    _hits.fetch_add(1, std::memory_order_relaxed);
+    return *result.first;
+  }
+
+  _misses.fetch_add(1, std::memory_order_relaxed);
+  shard.bytes += estimateMemoryUsage(*context);
+
+  size_t limit = _memoryLimit.load(std::memory_order_relaxed) / SHARD_COUNT;
+  if (limit > 0 && shard.bytes > std::max(limit, shard.nextEviction)) {
+    // Leave some room, so that not every add has to evict. The new context is not evicted, the caller holds it.
+    evict(shard, limit - limit / 4);
+
+    // If the contexts left are all still in use, the shard stays over the limit. Don't scan it again on every add
+    // then, but only after it grew by another quarter of the limit.
+    shard.nextEviction = shard.bytes > limit ? shard.bytes + limit / 4 : 0;
+  }
+
+  return context;
+}
+
+size_t PredictionContextCache::size() const {
+  size_t result = 0;
+  for (Shard &shard : _shards) {
+    std::unique_lock<std::mutex> lock { shard.mutex };
+    result += shard.data.size();
+  }
+  return result;
+}
+
+void PredictionContextCache::clear() {
+  for (Shard &shard : _shards) {
+    std::unique_lock<std::mutex> lock { shard.mutex };
+    shard.data.clear();
+    shard.bytes = 0;
+    shard.nextEviction = 0;
+  }
+}
+
+void PredictionContextCache::setMemoryLimit(size_t bytes) {
+  _memoryLimit.store(bytes, std::memory_order_relaxed);
+}
+
+size_t PredictionContextCache::getMemoryLimit() const {
+  return _memoryLimit.load(std::memory_order_relaxed);
+}
+
+PredictionContextCache::Statistics PredictionContextCache::getStatistics() const {
+  Statistics result;
+  result.size = 0;
+  result.bytes = 0;
+  for (Shard &shard : _shards) {
+    std::unique_lock<std::mutex> lock { shard.mutex };
+    result.size += shard.data.size();
+    result.bytes += shard.bytes;
+  }
+  result.hits = _hits.load(std::memory_order_relaxed);
+  result.misses = _misses.load(std::memory_order_relaxed);
+  result.evictions = _evictions.load(std::memory_order_relaxed);
+  return result;
+}
+
+PredictionContextCache::Shard& PredictionContextCache::getShard(PredictionContext const& context) const {
+  return _shards[context.hashCode() % SHARD_COUNT];
+}
+
+void PredictionContextCache::evict(Shard &shard, size_t limit) {
+  size_t evicted = 0;
+
+  // Only contexts nobody else refers to anymore are dropped. Dropping a context which is still in use would free
+  // nothing, and equal contexts added later would no longer share it.
+  for (auto iterator = shard.data.begin(); iterator != shard.data.end() && shard.bytes > limit;) {
+    if ((*iterator)->getReferenceCount() > 1) {
+      ++iterator;
+      continue;
+    }
+
+    shard.bytes -= estimateMemoryUsage(**iterator);
+    iterator = shard.data.erase(iterator);
+    ++evicted;
+  }
+
+  _evictions.fetch_add(evicted, std::memory_order_relaxed);
+}
+
 //----------------- PredictionContextMergeCache ------------------------------------------------------------------------
 
-Ref<PredictionContext> PredictionContextMergeCache::put(Ref<PredictionContext> const& key1, Ref<PredictionContext> const& key2,
-                                                        Ref<PredictionContext> const& value) {
-  Ref<PredictionContext> previous;
+IntrusivePtr<PredictionContext> PredictionContextMergeCache::put(IntrusivePtr<PredictionContext> const& key1, IntrusivePtr<PredictionContext> const& key2,
+                                                        IntrusivePtr<PredictionContext> const& value) {
+  IntrusivePtr<PredictionContext> previous;
 
   auto iterator = _data.find(key1);
   if (iterator == _data.end())
@@ -628,7 +750,7 @@ Ref<PredictionContext> PredictionContextMergeCache::put(Ref<PredictionContext> c
   return previous;
 }
 
-Ref<PredictionContext> PredictionContextMergeCache::get(Ref<PredictionContext> const& key1, Ref<PredictionContext> const& key2) {
+IntrusivePtr<PredictionContext> PredictionContextMergeCache::get(IntrusivePtr<PredictionContext> const& key1, IntrusivePtr<PredictionContext> const& key2) {
   auto iterator = _data.find(key1);
   if (iterator == _data.end())
     return nullptr;
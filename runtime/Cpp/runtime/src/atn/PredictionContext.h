@@ -8,21 +8,25 @@
 #include "Recognizer.h"
 #include "atn/ATN.h"
 #include "atn/ATNState.h"
+#include "support/IntrusivePtr.h"
 
 namespace antlr4 {
 namespace atn {
 
+  using antlrcpp::IntrusivePtr;
+
   struct PredictionContextHasher;
   struct PredictionContextComparer;
   class PredictionContextMergeCache;
+  class PredictionContextCache;
 
-  typedef std::unordered_set<Ref<PredictionContext>, PredictionContextHasher, PredictionContextComparer> PredictionContextCache;
-
-  class ANTLR4CPP_PUBLIC PredictionContext {
+  /// Prediction contexts are created and merged at a high rate during prediction, so they are reference counted
+  /// intrusively instead of being managed by std::shared_ptr.
+  class ANTLR4CPP_PUBLIC PredictionContext : public antlrcpp::IntrusiveRefCounted {
   public:
     /// Represents $ in local context prediction, which means wildcard.
     /// *+x = *.
-    static const Ref<PredictionContext> EMPTY;
+    static const IntrusivePtr<PredictionContext> EMPTY;
 
     /// Represents $ in an array in full context mode, when $
     /// doesn't mean wildcard: $ + x = [$,x]. Here,
@@ -81,10 +85,10 @@ namespace atn {
   public:
     /// Convert a RuleContext tree to a PredictionContext graph.
     /// Return EMPTY if outerContext is empty.
-    static Ref<PredictionContext> fromRuleContext(const ATN &atn, RuleContext *outerContext);
+    static IntrusivePtr<PredictionContext> fromRuleContext(const ATN &atn, RuleContext *outerContext);
 
     virtual size_t size() const = 0;
-    virtual Ref<PredictionContext> getParent(size_t index) const = 0;
+    virtual IntrusivePtr<PredictionContext> getParent(size_t index) const = 0;
     virtual size_t getReturnState(size_t index) const = 0;
 
     virtual bool operator == (const PredictionContext &o) const = 0;
@@ -96,13 +100,13 @@ namespace atn {
 
   protected:
     static size_t calculateEmptyHashCode();
-    static size_t calculateHashCode(Ref<PredictionContext> parent, size_t returnState);
-    static size_t calculateHashCode(const std::vector<Ref<PredictionContext>> &parents,
+    static size_t calculateHashCode(IntrusivePtr<PredictionContext> parent, size_t returnState);
+    static size_t calculateHashCode(const std::vector<IntrusivePtr<PredictionContext>> &parents,
                                     const std::vector<size_t> &returnStates);
 
   public:
     // dispatch
-    static Ref<PredictionContext> merge(const Ref<PredictionContext> &a, const Ref<PredictionContext> &b,
+    static IntrusivePtr<PredictionContext> merge(const IntrusivePtr<PredictionContext> &a, const IntrusivePtr<PredictionContext> &b,
                                         bool rootIsWildcard, PredictionContextMergeCache *mergeCache);
 
     /// <summary>
@@ -139,8 +143,8 @@ namespace atn {
     /// <param name="rootIsWildcard"> {@code true} if this is a local-context merge,
     /// otherwise false to indicate a full-context merge </param>
     /// <param name="mergeCache"> </param>
-    static Ref<PredictionContext> mergeSingletons(const Ref<SingletonPredictionContext> &a,
-      const Ref<SingletonPredictionContext> &b, bool rootIsWildcard, PredictionContextMergeCache *mergeCache);
+    static IntrusivePtr<PredictionContext> mergeSingletons(const IntrusivePtr<SingletonPredictionContext> &a,
+      const IntrusivePtr<SingletonPredictionContext> &b, bool rootIsWildcard, PredictionContextMergeCache *mergeCache);
 
     /**
      * Handle case where at least one of {@code a} or {@code b} is
@@ -180,8 +184,8 @@ namespace atn {
      * @param rootIsWildcard {@code true} if this is a local-context merge,
      * otherwise false to indicate a full-context merge
      */
-    static Ref<PredictionContext> mergeRoot(const Ref<SingletonPredictionContext> &a,
-      const Ref<SingletonPredictionContext> &b, bool rootIsWildcard);
+    static IntrusivePtr<PredictionContext> mergeRoot(const IntrusivePtr<SingletonPredictionContext> &a,
+      const IntrusivePtr<SingletonPredictionContext> &b, bool rootIsWildcard);
 
     /**
      * Merge two {@link ArrayPredictionContext} instances.
@@ -202,41 +206,41 @@ namespace atn {
      * {@link SingletonPredictionContext}.<br>
      * <embed src="images/ArrayMerge_EqualTop.svg" type="image/svg+xml"/></p>
      */
-    static Ref<PredictionContext> mergeArrays(const Ref<ArrayPredictionContext> &a,
-      const Ref<ArrayPredictionContext> &b, bool rootIsWildcard, PredictionContextMergeCache *mergeCache);
+    static IntrusivePtr<PredictionContext> mergeArrays(const IntrusivePtr<ArrayPredictionContext> &a,
+      const IntrusivePtr<ArrayPredictionContext> &b, bool rootIsWildcard, PredictionContextMergeCache *mergeCache);
 
   protected:
     /// Make pass over all M parents; merge any equal() ones.
     /// @returns true if the list has been changed (i.e. duplicates where found).
-    static bool combineCommonParents(std::vector<Ref<PredictionContext>> &parents);
+    static bool combineCommonParents(std::vector<IntrusivePtr<PredictionContext>> &parents);
 
   public:
-    static std::string toDOTString(const Ref<PredictionContext> &context);
+    static std::string toDOTString(const IntrusivePtr<PredictionContext> &context);
 
-    static Ref<PredictionContext> getCachedContext(const Ref<PredictionContext> &context,
+    static IntrusivePtr<PredictionContext> getCachedContext(const IntrusivePtr<PredictionContext> &context,
       PredictionContextCache &contextCache,
-      std::map<Ref<PredictionContext>, Ref<PredictionContext>> &visited);
+      std::map<IntrusivePtr<PredictionContext>, IntrusivePtr<PredictionContext>> &visited);
 
     // ter's recursive version of Sam's getAllNodes()
-    static std::vector<Ref<PredictionContext>> getAllContextNodes(const Ref<PredictionContext> &context);
-    static void getAllContextNodes_(const Ref<PredictionContext> &context,
-      std::vector<Ref<PredictionContext>> &nodes, std::set<PredictionContext *> &visited);
+    static std::vector<IntrusivePtr<PredictionContext>> getAllContextNodes(const IntrusivePtr<PredictionContext> &context);
+    static void getAllContextNodes_(const IntrusivePtr<PredictionContext> &context,
+      std::vector<IntrusivePtr<PredictionContext>> &nodes, std::set<PredictionContext *> &visited);
 
     virtual std::string toString() const;
     virtual std::string toString(Recognizer *recog) const;
 
     std::vector<std::string> toStrings(Recognizer *recognizer, int currentState);
-    std::vector<std::string> toStrings(Recognizer *recognizer, const Ref<PredictionContext> &stop, int currentState);
+    std::vector<std::string> toStrings(Recognizer *recognizer, const IntrusivePtr<PredictionContext> &stop, int currentState);
   };
 
   struct PredictionContextHasher {
-    size_t operator () (const Ref<PredictionContext> &k) const {
+    size_t operator () (const IntrusivePtr<PredictionContext> &k) const {
       return k->hashCode();
     }
   };
 
   struct PredictionContextComparer {
-    bool operator () (const Ref<PredictionContext> &lhs, const Ref<PredictionContext> &rhs) const
+    bool operator () (const IntrusivePtr<PredictionContext> &lhs, const IntrusivePtr<PredictionContext> &rhs) const
     {
       if (lhs == rhs) // Object identity.
         return true;
@@ -244,19 +248,93 @@ namespace atn {
     }
   };
 
+  /// Maps all PredictionContext objects that are equal to a single cached copy. A cache is usually shared by all
+  /// simulators (and all decisions) of a grammar, so it does its own locking instead of relying on a DFA lock.
+  /// The contexts are spread over several independently locked shards, to keep contention low.
+  ///
+  /// By default the cache grows without bounds. With a memory limit set, a shard which exceeds its part of the limit
+  /// drops contexts which are referenced by nothing but the cache, until it is well below the limit. Contexts still
+  /// referenced by DFA states or configurations are kept, as dropping them would free no memory. A shard whose
+  /// contexts are all in use therefore stays above its part of the limit.
+  class ANTLR4CPP_PUBLIC PredictionContextCache {
+  public:
+    struct Statistics {
+      size_t size;      // The number of cached contexts.
+      size_t bytes;     // The estimated memory used by the cached contexts.
+      size_t hits;      // Successful lookups, including adds of contexts already cached.
+      size_t misses;    // Failed lookups, including adds of new contexts.
+      size_t evictions; // Contexts dropped to stay within the memory limit.
+    };
+
+    /// Creates a cache with the given memory limit in bytes, 0 means unlimited.
+    explicit PredictionContextCache(size_t memoryLimit = 0);
+
+    /// Returns the cached context that is equal to the given one or null, if there is none.
+    IntrusivePtr<PredictionContext> get(IntrusivePtr<PredictionContext> const& context) const;
+
+    /// Adds the given context to the cache, unless an equal context is already there.
+    /// Returns the cached instance in either case.
+    IntrusivePtr<PredictionContext> add(IntrusivePtr<PredictionContext> const& context);
+
+    size_t size() const;
+    void clear();
+
+    /// Sets the limit for the estimated memory used by the cached contexts, in bytes. 0 means unlimited.
+    /// The limit applies from the next add() on.
+    void setMemoryLimit(size_t bytes);
+    size_t getMemoryLimit() const;
+
+    Statistics getStatistics() const;
+
+  private:
+#if __cplusplus >= 201703L
+    static constexpr size_t SHARD_COUNT = 16;
+#else
+    enum : size_t {
+      SHARD_COUNT = 16,
+    };
+#endif
+
+    struct Shard {
+      Shard() : bytes(0), nextEviction(0) {
+      }
+
+      std::mutex mutex;
+      std::unordered_set<IntrusivePtr<PredictionContext>, PredictionContextHasher, PredictionContextComparer> data;
+      size_t bytes;
+
+      // The size above which the next eviction is tried, when the last one left the shard over the limit.
+      size_t nextEviction;
+    };
+
+    mutable Shard _shards[SHARD_COUNT];
+    std::atomic<size_t> _memoryLimit;
+    mutable std::atomic<size_t> _hits;
+    mutable std::atomic<size_t> _misses;
+    std::atomic<size_t> _evictions;
+
+    Shard& getShard(PredictionContext const& context) const;
+
+    /// Drops unused contexts from {@code shard} until its estimated memory use is at most {@code limit}, or no unused
+    /// context is left.
+    /// The caller must hold the shard's lock.
+    void evict(Shard &shard, size_t limit);
+  };
+
   class PredictionContextMergeCache {
   public:
-    Ref<PredictionContext> put(Ref<PredictionContext> const& key1, Ref<PredictionContext> const& key2,
-                               Ref<PredictionContext> const& value);
-    Ref<PredictionContext> get(Ref<PredictionContext> const& key1, Ref<PredictionContext> const& key2);
+    IntrusivePtr<PredictionContext> put(IntrusivePtr<PredictionContext> const& key1,
+                                        IntrusivePtr<PredictionContext> const& key2,
+                                        IntrusivePtr<PredictionContext> const& value);
+    IntrusivePtr<PredictionContext> get(IntrusivePtr<PredictionContext> const& key1, IntrusivePtr<PredictionContext> const& key2);
 
     void clear();
     std::string toString() const;
     size_t count() const;
 
   private:
-    std::unordered_map<Ref<PredictionContext>,
-      std::unordered_map<Ref<PredictionContext>, Ref<PredictionContext>, PredictionContextHasher, PredictionContextComparer>,
+    std::unordered_map<IntrusivePtr<PredictionContext>,
+      std::unordered_map<IntrusivePtr<PredictionContext>, IntrusivePtr<PredictionContext>, PredictionContextHasher, PredictionContextComparer>,
       PredictionContextHasher, PredictionContextComparer> _data;
 
   };
@@ -24,7 +24,7 @@ struct AltAndContextConfigHasher
   size_t operator () (ATNConfig *o) const {
     size_t hashCode = misc::MurmurHash::initialize(7);
     hashCode = misc::MurmurHash::update(hashCode, o->state->stateNumber);
-    hashCode = misc::MurmurHash::update(hashCode, o->context);
+    hashCode = misc::MurmurHash::update(hashCode, o->context.get());
     return misc::MurmurHash::finish(hashCode, 2);
   }
 };
@@ -8,8 +8,9 @@
 #include "atn/SingletonPredictionContext.h"
 
 using namespace antlr4::atn;
+using namespace antlrcpp;
 
-SingletonPredictionContext::SingletonPredictionContext(Ref<PredictionContext> const& parent, size_t returnState)
+SingletonPredictionContext::SingletonPredictionContext(IntrusivePtr<PredictionContext> const& parent, size_t returnState)
   : PredictionContext(parent ? calculateHashCode(parent, returnState) : calculateEmptyHashCode()),
     parent(parent), returnState(returnState) {
   assert(returnState != ATNState::INVALID_STATE_NUMBER);
@@ -18,20 +19,20 @@ SingletonPredictionContext::SingletonPredictionContext(Ref<PredictionContext> co
 SingletonPredictionContext::~SingletonPredictionContext() {
 }
 
-Ref<SingletonPredictionContext> SingletonPredictionContext::create(Ref<PredictionContext> const& parent, size_t returnState) {
+IntrusivePtr<SingletonPredictionContext> SingletonPredictionContext::create(IntrusivePtr<PredictionContext> const& parent, size_t returnState) {
 
   if (returnState == EMPTY_RETURN_STATE && parent) {
     // someone can pass in the bits of an array ctx that mean $
-    return std::dynamic_pointer_cast<SingletonPredictionContext>(EMPTY);
+    return dynamic_pointer_cast<SingletonPredictionContext>(EMPTY);
   }
-  return std::make_shared<SingletonPredictionContext>(parent, returnState);
+  return makeIntrusive<SingletonPredictionContext>(parent, returnState);
 }
 
 size_t SingletonPredictionContext::size() const {
   return 1;
 }
 
-Ref<PredictionContext> SingletonPredictionContext::getParent(size_t index) const {
+IntrusivePtr<PredictionContext> SingletonPredictionContext::getParent(size_t index) const {
   assert(index == 0);
   ((void)(index)); // Make Release build happy.
   return parent;
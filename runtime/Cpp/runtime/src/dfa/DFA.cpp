@@ -15,45 +15,56 @@ using namespace antlr4;
 using namespace antlr4::dfa;
 using namespace antlrcpp;
 
+std::atomic<size_t> DFA::_useClock(0);
+
 DFA::DFA(atn::DecisionState *atnStartState) : DFA(atnStartState, 0) {
 }
 
 DFA::DFA(atn::DecisionState *atnStartState, size_t decision)
   : atnStartState(atnStartState), s0(nullptr), decision(decision) {
+  InitializeInstanceFields();
 
   _precedenceDfa = false;
   if (is<atn::StarLoopEntryState *>(atnStartState)) {
     if (static_cast<atn::StarLoopEntryState *>(atnStartState)->isPrecedenceDecision) {
       _precedenceDfa = true;
-      s0 = new DFAState(std::unique_ptr<atn::ATNConfigSet>(new atn::ATNConfigSet()));
-      s0->isAcceptState = false;
-      s0->requiresFullContext = false;
+      s0 = createPrecedenceStartState();
     }
   }
 }
 
 DFA::DFA(DFA &&other) : atnStartState(other.atnStartState), decision(other.decision) {
+  InitializeInstanceFields();
+
   // Source states are implicitly cleared by the move.
   states = std::move(other.states);
+  _retiredStates = std::move(other._retiredStates);
+  _hasRetiredStates = !_retiredStates.empty();
+  other._hasRetiredStates = false;
+  _memoryUsage = other._memoryUsage.exchange(0);
 
   other.atnStartState = nullptr;
   other.decision = 0;
-  s0 = other.s0;
-  other.s0 = nullptr;
+  s0.store(other.s0.exchange(nullptr));
   _precedenceDfa = other._precedenceDfa;
   other._precedenceDfa = false;
 }
 
 DFA::~DFA() {
-  bool s0InList = (s0 == nullptr);
+  DFAState *start = s0.load();
+  bool s0InList = (start == nullptr);
   for (auto *state : states) {
-    if (state == s0)
+    if (state == start)
       s0InList = true;
     delete state;
   }
 
   if (!s0InList)
-    delete s0;
+    delete start;
+
+  for (auto *state : _retiredStates) {
+    delete state;
+  }
 }
 
 bool DFA::isPrecedenceDfa() const {
@@ -63,14 +74,14 @@ bool DFA::isPrecedenceDfa() const {
 DFAState* DFA::getPrecedenceStartState(int precedence) const {
   assert(_precedenceDfa); // Only precedence DFAs may contain a precedence start state.
 
-  auto iterator = s0->edges.find(precedence);
-  if (iterator == s0->edges.end())
+  if (precedence < 0) {
     return nullptr;
+  }
 
-  return iterator->second;
+  return s0.load(std::memory_order_acquire)->getEdge(static_cast<size_t>(precedence));
 }
 
-void DFA::setPrecedenceStartState(int precedence, DFAState *startState, SingleWriteMultipleReadLock &lock) {
+void DFA::setPrecedenceStartState(int precedence, DFAState *startState) {
   if (!isPrecedenceDfa()) {
     throw IllegalStateException("Only precedence DFAs may contain a precedence start state.");
   }
@@ -79,11 +90,7 @@ void DFA::setPrecedenceStartState(int precedence, DFAState *startState, SingleWr
     return;
   }
 
-  {
-    lock.writeLock();
-    s0->edges[precedence] = startState;
-    lock.writeUnlock();
-  }
+  s0.load(std::memory_order_acquire)->setEdge(static_cast<size_t>(precedence), startState);
 }
 
 std::vector<DFAState *> DFA::getStates() const {
@@ -125,3 +132,96 @@ std::string DFA::toLexerString() {
   return serializer.toString();
 }
 
+std::mutex& DFA::getStateLock() {
+  return _stateLock;
+}
+
+size_t DFA::getMemoryUsage() const {
+  return _memoryUsage.load(std::memory_order_relaxed);
+}
+
+void DFA::addMemoryUsage(size_t bytes) {
+  _memoryUsage.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void DFA::beginUse() {
+  // Synchronizes with the read-modify-write in takeUnusedRetiredStates(), so a user either blocks the deletion
+  // of retired states or sees the start state which replaced them.
+  _users.fetch_add(1);
+  _lastUse.store(_useClock.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void DFA::endUse() {
+  _users.fetch_sub(1);
+  if (!_hasRetiredStates.load()) {
+    return;
+  }
+
+  std::vector<DFAState *> unused;
+  {
+    std::unique_lock<std::mutex> lock { _stateLock };
+    unused = takeUnusedRetiredStates();
+  }
+  for (auto *state : unused) {
+    delete state;
+  }
+}
+
+size_t DFA::getLastUse() const {
+  return _lastUse.load(std::memory_order_relaxed);
+}
+
+void DFA::advanceUseClock() {
+  _useClock.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DFA::clearStates() {
+  std::vector<DFAState *> unused;
+  {
+    std::unique_lock<std::mutex> lock { _stateLock };
+    DFAState *start = s0.load(std::memory_order_relaxed);
+    bool s0InList = (start == nullptr);
+    for (auto *state : states) {
+      if (state == start)
+        s0InList = true;
+      _retiredStates.push_back(state);
+    }
+    if (!s0InList)
+      _retiredStates.push_back(start);
+
+    states.clear();
+    s0.store(_precedenceDfa ? createPrecedenceStartState() : nullptr, std::memory_order_release);
+    _memoryUsage = 0;
+    _hasRetiredStates = true;
+
+    unused = takeUnusedRetiredStates();
+  }
+
+  for (auto *state : unused) {
+    delete state;
+  }
+}
+
+void DFA::InitializeInstanceFields() {
+  _users = 0;
+  _lastUse = 0;
+  _memoryUsage = 0;
+  _hasRetiredStates = false;
+}
+
+DFAState* DFA::createPrecedenceStartState() const {
+  DFAState *result = new DFAState(std::unique_ptr<atn::ATNConfigSet>(new atn::ATNConfigSet())); /* mem-check: owned by the DFA */
+  result->isAcceptState = false;
+  result->requiresFullContext = false;
+  return result;
+}
+
+std::vector<DFAState *> DFA::takeUnusedRetiredStates() {
+  std::vector<DFAState *> result;
+  if (_users.fetch_add(0) == 0) {
+    result.swap(_retiredStates);
+    _hasRetiredStates = false;
+  }
+  return result;
+}
+
@@ -7,10 +7,6 @@
 
 #include "dfa/DFAState.h"
 
-namespace antlrcpp {
-  class SingleWriteMultipleReadLock;
-}
-
 namespace antlr4 {
 namespace dfa {
 
@@ -22,7 +18,10 @@ namespace dfa {
     /// From which ATN state did we create this DFA?
     atn::DecisionState *atnStartState;
     std::unordered_set<DFAState *, DFAState::Hasher, DFAState::Comparer> states; // States are owned by this class.
-    DFAState *s0;
+    /// The start state. It is written with the state lock held, and replaced when the states are cleared, but the
+    /// simulators read it without the lock, so it is atomic. Load it once (with memory_order_acquire) and use that
+    /// value, it may change between two reads.
+    std::atomic<DFAState *> s0;
     size_t decision;
 
     DFA(atn::DecisionState *atnStartState);
@@ -34,7 +33,7 @@ namespace dfa {
     /**
      * Gets whether this DFA is a precedence DFA. Precedence DFAs use a special
      * start state {@link #s0} which is not stored in {@link #states}. The
-     * {@link DFAState#edges} array for this start state contains outgoing edges
+     * {@link DFAState#getEdge edges} of this start state contain outgoing edges
      * supplying individual start states corresponding to specific precedence
      * values.
      *
@@ -66,7 +65,7 @@ namespace dfa {
      * @throws IllegalStateException if this is not a precedence DFA.
      * @see #isPrecedenceDfa()
      */
-    void setPrecedenceStartState(int precedence, DFAState *startState, antlrcpp::SingleWriteMultipleReadLock &lock);
+    void setPrecedenceStartState(int precedence, DFAState *startState);
 
     /// Return a list of all states in this DFA, ordered by state number.
     virtual std::vector<DFAState *> getStates() const;
@@ -79,12 +78,54 @@ namespace dfa {
 
     virtual std::string toLexerString();
 
+    /// The lock that guards {@link #states} and the start state while a simulator adds new states.
+    /// Each DFA has its own lock, so warming up one decision (or grammar) never blocks another one.
+    std::mutex& getStateLock();
+
+    /// The estimated memory used by the states of this DFA, as reported with addMemoryUsage() by the simulator
+    /// which adds them.
+    size_t getMemoryUsage() const;
+    void addMemoryUsage(size_t bytes);
+
+    /// Marks the calling thread as using the states of this DFA until the matching endUse() call. States dropped by
+    /// clearStates() are deleted only once no thread uses the DFA anymore.
+    void beginUse();
+    void endUse();
+
+    /// The value of the use clock at the most recent beginUse() call. The clock is advanced with advanceUseClock(),
+    /// so DFAs with a smaller value were used less recently.
+    size_t getLastUse() const;
+    static void advanceUseClock();
+
+    /// Drops all states, so that the DFA is built again on demand. This is safe while other threads use the DFA
+    /// (see beginUse()), but not while they iterate over its states otherwise, e.g. to print it.
+    void clearStates();
+
   private:
+    static std::atomic<size_t> _useClock;
+
+    std::mutex _stateLock;
+
+    std::atomic<size_t> _users;
+    std::atomic<size_t> _lastUse;
+    std::atomic<size_t> _memoryUsage;
+
+    /// States dropped by clearStates() which may still be in use. Guarded by the state lock.
+    std::vector<DFAState *> _retiredStates;
+    std::atomic<bool> _hasRetiredStates;
+
     /**
      * {@code true} if this DFA is for a precedence decision; otherwise,
      * {@code false}. This is the backing field for {@link #isPrecedenceDfa}.
      */
     bool _precedenceDfa;
+
+    void InitializeInstanceFields();
+    DFAState* createPrecedenceStartState() const;
+
+    /// Returns the retired states if no thread uses this DFA, or nothing otherwise. The caller must hold the state
+    /// lock and delete the returned states after releasing it.
+    std::vector<DFAState *> takeUnusedRetiredStates();
   };
 
 } // namespace atn
@@ -28,8 +28,8 @@ std::string DFASerializer::toString() const {
   std::stringstream ss;
   std::vector<DFAState *> states = _dfa->getStates();
   for (auto *s : states) {
-    for (size_t i = 0; i < s->edges.size(); i++) {
-      DFAState *t = s->edges[i];
+    for (size_t i = 0; i < s->getEdgeCount(); i++) {
+      DFAState *t = s->getEdge(i);
       if (t != nullptr && t->stateNumber != INT32_MAX) {
         ss << getStateString(s);
         std::string label = getEdgeLabel(i);
@@ -42,7 +42,7 @@ std::string DFASerializer::toString() const {
 }
 
 std::string DFASerializer::getEdgeLabel(size_t i) const {
-  return _vocabulary.getDisplayName(i); // ml: no longer needed -1 as we use a map for edges, without offset.
+  return _vocabulary.getDisplayName(i - 1); // Edges are shifted by 1 so that EOF maps to edge 0.
 }
 
 std::string DFASerializer::getStateString(DFAState *s) const {
@@ -0,0 +1,779 @@
+/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#include "atn/ATN.h"
+#include "atn/ATNType.h"
+#include "atn/ATNSerializer.h"
+#include "atn/ATNSimulator.h"
+#include "atn/ATNConfigSet.h"
+#include "atn/OrderedATNConfigSet.h"
+#include "atn/LexerATNConfig.h"
+#include "atn/LexerATNSimulator.h"
+#include "atn/ParserATNSimulator.h"
+#include "atn/EmptyPredictionContext.h"
+#include "atn/SingletonPredictionContext.h"
+#include "atn/ArrayPredictionContext.h"
+#include "atn/SemanticContext.h"
+#include "atn/LexerActionExecutor.h"
+#include "atn/LexerIndexedCustomAction.h"
+#include "misc/MurmurHash.h"
+#include "Exceptions.h"
+#include "support/CPPUtils.h"
+
+#include "dfa/DFASnapshot.h"
+
+#include <cstring>
+
+using namespace antlr4;
+using namespace antlr4::atn;
+using namespace antlr4::dfa;
+using namespace antlrcpp;
+
+namespace {
+
+  // "ADFA" when written in little endian byte order. A snapshot written with the other byte order doesn't match.
+  const uint32_t SNAPSHOT_MAGIC = 0x41464441;
+  const uint32_t SNAPSHOT_VERSION = 1;
+
+  // Marks a missing reference or value, e.g. a null parent context or INVALID_INDEX.
+  const uint32_t NO_ID = 0xFFFFFFFF;
+
+  // The edge target id of ATNSimulator::ERROR.
+  const uint32_t ERROR_ID = 0xFFFFFFFE;
+
+  // Edge tables of lexer and parser DFA states are much smaller than this, a larger value means a damaged snapshot.
+  const uint32_t MAX_EDGE_TABLE_SIZE = 0x100000;
+
+  enum : uint32_t {
+    SINGLETON_CONTEXT = 1,
+    ARRAY_CONTEXT = 2,
+  };
+
+  enum : uint32_t {
+    PREDICATE = 1,
+    PRECEDENCE_PREDICATE = 2,
+    AND_CONTEXT = 3,
+    OR_CONTEXT = 4,
+  };
+
+  enum : uint32_t {
+    PLAIN_ACTION = 0,
+    INDEXED_CUSTOM_ACTION = 1,
+  };
+
+  // DFA flags.
+  const uint32_t PRECEDENCE_DFA = 1;
+
+  // DFA state flags.
+  const uint32_t ACCEPT_STATE = 1;
+  const uint32_t REQUIRES_FULL_CONTEXT = 2;
+
+  // Configuration set flags.
+  const uint32_t HAS_SEMANTIC_CONTEXT = 1;
+  const uint32_t DIPS_INTO_OUTER_CONTEXT = 2;
+  const uint32_t FULL_CONTEXT = 4;
+
+  uint32_t toWord(size_t value) {
+    if (value == std::numeric_limits<size_t>::max()) {
+      return NO_ID;
+    }
+    if (value >= NO_ID) {
+      throw IllegalArgumentException("Value " + std::to_string(value) + " does not fit into a DFA snapshot.");
+    }
+    return static_cast<uint32_t>(value);
+  }
+
+  size_t fromWord(uint32_t word) {
+    return word == NO_ID ? std::numeric_limits<size_t>::max() : word;
+  }
+
+  uint32_t toReturnStateWord(size_t returnState) {
+    return returnState == PredictionContext::EMPTY_RETURN_STATE ? NO_ID : toWord(returnState);
+  }
+
+  size_t fromReturnStateWord(uint32_t word) {
+    if (word == NO_ID) {
+      return PredictionContext::EMPTY_RETURN_STATE;
+    }
+    return word;
+  }
+
+  // The ATN in serialized form plus the settings which determine the layout of DFA edge tables.
+  size_t getFingerprint(const ATN &atn) {
+    std::vector<size_t> serialized = ATNSerializer(const_cast<ATN *>(&atn)).serialize();
+
+    size_t hash = misc::MurmurHash::initialize();
+    for (size_t value : serialized) {
+      hash = misc::MurmurHash::update(hash, value);
+    }
+    hash = misc::MurmurHash::update(hash, static_cast<size_t>(LexerATNSimulator::MAX_DFA_EDGE));
+    hash = misc::MurmurHash::update(hash, atn.charClasses.size());
+    return misc::MurmurHash::finish(hash, serialized.size() + 2);
+  }
+
+  class SnapshotWriter {
+  public:
+    SnapshotWriter(const ATN &atn) : _atn(atn), _isLexer(atn.grammarType == ATNType::LEXER) {
+      _contextCount = 1; // Id 0 is PredictionContext::EMPTY.
+      _semanticContextCount = 1; // Id 0 is SemanticContext::NONE.
+      _executorCount = 1; // Id 0 is no executor.
+    }
+
+    void writeDFA(DFA &dfa) {
+      std::unique_lock<std::mutex> lock { dfa.getStateLock() };
+
+      std::vector<DFAState *> states = dfa.getStates();
+      std::unordered_map<const DFAState *, uint32_t> ids;
+      for (size_t i = 0; i < states.size(); ++i) {
+        ids[states[i]] = static_cast<uint32_t>(i);
+      }
+
+      // The start state of a precedence DFA is not in the state set, it follows the other states.
+      DFAState *start = dfa.s0.load(std::memory_order_acquire);
+      uint32_t s0 = NO_ID;
+      if (start != nullptr) {
+        auto iterator = ids.find(start);
+        s0 = iterator != ids.end() ? iterator->second : static_cast<uint32_t>(states.size());
+      }
+
+      _states.push_back(dfa.isPrecedenceDfa() ? PRECEDENCE_DFA : 0);
+      _states.push_back(static_cast<uint32_t>(states.size()));
+      _states.push_back(s0);
+      for (auto *state : states) {
+        writeState(state, ids);
+      }
+      if (s0 == states.size()) {
+        writeState(start, ids);
+      }
+    }
+
+    std::string getResult(size_t dfaCount) {
+      std::vector<uint32_t> header;
+      size_t fingerprint = getFingerprint(_atn);
+      header.push_back(SNAPSHOT_MAGIC);
+      header.push_back(SNAPSHOT_VERSION);
+      header.push_back(static_cast<uint32_t>(fingerprint));
+      header.push_back(static_cast<uint32_t>(static_cast<uint64_t>(fingerprint) >> 32));
+      header.push_back(static_cast<uint32_t>(_atn.grammarType));
+      header.push_back(toWord(dfaCount));
+
+      std::string result;
+      append(result, header);
+      append(result, { _contextCount - 1 });
+      append(result, _contexts);
+      append(result, { _semanticContextCount - 1 });
+      append(result, _semanticContexts);
+      append(result, { _executorCount - 1 });
+      append(result, _executors);
+      append(result, _states);
+      return result;
+    }
+
+  private:
+    const ATN &_atn;
+    const bool _isLexer;
+
+    // Each table lists its entries in id order, and an entry only refers to entries with a smaller id.
+    std::vector<uint32_t> _contexts;
+    uint32_t _contextCount;
+    std::unordered_map<const PredictionContext *, uint32_t> _contextIds;
+
+    std::vector<uint32_t> _semanticContexts;
+    uint32_t _semanticContextCount;
+    std::unordered_map<const SemanticContext *, uint32_t> _semanticContextIds;
+
+    std::vector<uint32_t> _executors;
+    uint32_t _executorCount;
+    std::unordered_map<const LexerActionExecutor *, uint32_t> _executorIds;
+
+    std::vector<uint32_t> _states;
+
+    static void append(std::string &target, const std::vector<uint32_t> &words) {
+      target.append(reinterpret_cast<const char *>(words.data()), words.size() * sizeof(uint32_t));
+    }
+
+    uint32_t getContextId(const PredictionContext *context) {
+      if (context == nullptr) {
+        return NO_ID;
+      }
+      if (dynamic_cast<const EmptyPredictionContext *>(context) != nullptr) {
+        return 0;
+      }
+
+      auto iterator = _contextIds.find(context);
+      if (iterator != _contextIds.end()) {
+        return iterator->second;
+      }
+
+      std::vector<uint32_t> parents;
+      for (size_t i = 0; i < context->size(); ++i) {
+        parents.push_back(getContextId(context->getParent(i).get()));
+      }
+
+      if (dynamic_cast<const ArrayPredictionContext *>(context) != nullptr) {
+        _contexts.push_back(ARRAY_CONTEXT);
+        _contexts.push_back(static_cast<uint32_t>(parents.size()));
+      } else {
+        _contexts.push_back(SINGLETON_CONTEXT);
+      }
+      for (size_t i = 0; i < parents.size(); ++i) {
+        _contexts.push_back(parents[i]);
+        _contexts.push_back(toReturnStateWord(context->getReturnState(i)));
+      }
+
+      _contextIds[context] = _contextCount;
+      return _contextCount++;
+    }
+
+    uint32_t getSemanticContextId(const SemanticContext *context) {
+      if (context == nullptr) {
+        return NO_ID;
+      }
+      if (context == SemanticContext::NONE.get()) {
+        return 0;
+      }
+
+      auto iterator = _semanticContextIds.find(context);
+      if (iterator != _semanticContextIds.end()) {
+        return iterator->second;
+      }
+
+      if (auto predicate = dynamic_cast<const SemanticContext::Predicate *>(context)) {
+        _semanticContexts.push_back(PREDICATE);
+        _semanticContexts.push_back(toWord(predicate->ruleIndex));
+        _semanticContexts.push_back(toWord(predicate->predIndex));
+        _semanticContexts.push_back(predicate->isCtxDependent ? 1 : 0);
+      } else if (auto predicate = dynamic_cast<const SemanticContext::PrecedencePredicate *>(context)) {
+        _semanticContexts.push_back(PRECEDENCE_PREDICATE);
+        _semanticContexts.push_back(static_cast<uint32_t>(predicate->precedence));
+      } else if (auto op = dynamic_cast<const SemanticContext::Operator *>(context)) {
+        std::vector<uint32_t> operands;
+        for (auto &operand : op->getOperands()) {
+          operands.push_back(getSemanticContextId(operand.get()));
+        }
+        _semanticContexts.push_back(dynamic_cast<const SemanticContext::AND *>(context) != nullptr ? AND_CONTEXT : OR_CONTEXT);
+        _semanticContexts.push_back(static_cast<uint32_t>(operands.size()));
+        _semanticContexts.insert(_semanticContexts.end(), operands.begin(), operands.end());
+      } else {
+        throw UnsupportedOperationException("Unknown semantic context in DFA: " + context->toString());
+      }
+
+      _semanticContextIds[context] = _semanticContextCount;
+      return _semanticContextCount++;
+    }
+
+    uint32_t getLexerActionIndex(const Ref<LexerAction> &action) {
+      for (size_t i = 0; i < _atn.lexerActions.size(); ++i) {
+        if (_atn.lexerActions[i] == action || *_atn.lexerActions[i] == *action) {
+          return static_cast<uint32_t>(i);
+        }
+      }
+      throw UnsupportedOperationException("Lexer action in DFA is not part of the ATN: " + action->toString());
+    }
+
+    uint32_t getExecutorId(const LexerActionExecutor *executor) {
+      if (executor == nullptr) {
+        return 0;
+      }
+
+      auto iterator = _executorIds.find(executor);
+      if (iterator != _executorIds.end()) {
+        return iterator->second;
+      }
+
+      std::vector<Ref<LexerAction>> actions = executor->getLexerActions();
+      _executors.push_back(static_cast<uint32_t>(actions.size()));
+      for (auto &action : actions) {
+        if (is<LexerIndexedCustomAction>(action)) {
+          auto indexedAction = std::static_pointer_cast<LexerIndexedCustomAction>(action);
+          _executors.push_back(INDEXED_CUSTOM_ACTION);
+          _executors.push_back(static_cast<uint32_t>(indexedAction->getOffset()));
+          _executors.push_back(getLexerActionIndex(indexedAction->getAction()));
+        } else {
+          _executors.push_back(PLAIN_ACTION);
+          _executors.push_back(0);
+          _executors.push_back(getLexerActionIndex(action));
+        }
+      }
+
+      _executorIds[executor] = _executorCount;
+      return _executorCount++;
+    }
+
+    void writeConfigs(ATNConfigSet *configs) {
+      if (configs == nullptr) {
+        _states.push_back(NO_ID);
+        return;
+      }
+
+      _states.push_back(static_cast<uint32_t>(configs->configs.size()));
+      uint32_t flags = 0;
+      if (configs->hasSemanticContext)
+        flags |= HAS_SEMANTIC_CONTEXT;
+      if (configs->dipsIntoOuterContext)
+        flags |= DIPS_INTO_OUTER_CONTEXT;
+      if (configs->fullCtx)
+        flags |= FULL_CONTEXT;
+      _states.push_back(flags);
+      _states.push_back(toWord(configs->uniqueAlt));
+
+      _states.push_back(static_cast<uint32_t>(configs->conflictingAlts.count()));
+      for (size_t i = 0; i < configs->conflictingAlts.size(); ++i) {
+        if (configs->conflictingAlts.test(i)) {
+          _states.push_back(static_cast<uint32_t>(i));
+        }
+      }
+
+      for (auto &config : configs->configs) {
+        _states.push_back(toWord(config->state->stateNumber));
+        _states.push_back(toWord(config->alt));
+        _states.push_back(getContextId(config->context.get()));
+        _states.push_back(getSemanticContextId(config->semanticContext.get()));
+        _states.push_back(toWord(config->reachesIntoOuterContext));
+        if (_isLexer) {
+          auto lexerConfig = std::static_pointer_cast<LexerATNConfig>(config);
+          _states.push_back(getExecutorId(lexerConfig->getLexerActionExecutor().get()));
+          _states.push_back(lexerConfig->hasPassedThroughNonGreedyDecision() ? 1 : 0);
+        }
+      }
+    }
+
+    void writeState(DFAState *state, const std::unordered_map<const DFAState *, uint32_t> &ids) {
+      _states.push_back(static_cast<uint32_t>(state->stateNumber));
+      uint32_t flags = 0;
+      if (state->isAcceptState)
+        flags |= ACCEPT_STATE;
+      if (state->requiresFullContext)
+        flags |= REQUIRES_FULL_CONTEXT;
+      _states.push_back(flags);
+      _states.push_back(toWord(state->prediction));
+      _states.push_back(getExecutorId(state->lexerActionExecutor.get()));
+
+      _states.push_back(static_cast<uint32_t>(state->predicates.size()));
+      for (auto *predicate : state->predicates) {
+        _states.push_back(getSemanticContextId(predicate->pred.get()));
+        _states.push_back(static_cast<uint32_t>(predicate->alt));
+      }
+
+      writeConfigs(state->configs.get());
+
+      // Edges to states which are not in the DFA anymore (see DFA::clearStates()) are left out.
+      std::vector<uint32_t> edges;
+      size_t edgeCount = state->getEdgeCount();
+      for (size_t i = 0; i < edgeCount; ++i) {
+        DFAState *target = state->getEdge(i);
+        if (target == nullptr) {
+          continue;
+        }
+        if (target == ATNSimulator::ERROR.get()) {
+          edges.push_back(static_cast<uint32_t>(i));
+          edges.push_back(ERROR_ID);
+          continue;
+        }
+        auto iterator = ids.find(target);
+        if (iterator != ids.end()) {
+          edges.push_back(static_cast<uint32_t>(i));
+          edges.push_back(iterator->second);
+        }
+      }
+      _states.push_back(static_cast<uint32_t>(edgeCount));
+      _states.push_back(static_cast<uint32_t>(edges.size() / 2));
+      _states.insert(_states.end(), edges.begin(), edges.end());
+    }
+  };
+
+  class SnapshotReader {
+  public:
+    SnapshotReader(const char *data, size_t size) : _data(data), _size(size / sizeof(uint32_t)), _position(0) {
+    }
+
+    uint32_t next() {
+      if (_position >= _size) {
+        throw IllegalArgumentException("The DFA snapshot is truncated.");
+      }
+
+      uint32_t result;
+      std::memcpy(&result, _data + _position++ * sizeof(uint32_t), sizeof(uint32_t));
+      return result;
+    }
+
+    // Reads a word which must be smaller than limit.
+    uint32_t next(size_t limit, const char *what) {
+      uint32_t result = next();
+      if (result >= limit) {
+        throw IllegalArgumentException(std::string("The DFA snapshot is damaged (invalid ") + what + ").");
+      }
+      return result;
+    }
+
+    bool atEnd() const {
+      return _position == _size;
+    }
+
+  private:
+    const char *_data;
+    const size_t _size;
+    size_t _position;
+  };
+
+  // Checks the header and returns an empty string if the snapshot can be loaded for atn, or the reason why not.
+  std::string checkHeader(SnapshotReader &reader, const ATN &atn) {
+    if (reader.next() != SNAPSHOT_MAGIC) {
+      return "The data is not a DFA snapshot or was written on a machine with a different byte order.";
+    }
+    uint32_t version = reader.next();
+    if (version != SNAPSHOT_VERSION) {
+      return "Could not load DFA snapshot with version " + std::to_string(version) + " (expected " +
+        std::to_string(SNAPSHOT_VERSION) + ").";
+    }
+
+    size_t fingerprint = getFingerprint(atn);
+    uint64_t low = reader.next();
+    uint64_t high = reader.next();
+    if (static_cast<uint64_t>(static_cast<uint32_t>(fingerprint)) != low ||
+        (static_cast<uint64_t>(fingerprint) >> 32) != high) {
+      return "The DFA snapshot was taken from a different ATN.";
+    }
+    if (reader.next() != static_cast<uint32_t>(atn.grammarType) || reader.next() != atn.getNumberOfDecisions()) {
+      return "The DFA snapshot was taken from a different ATN.";
+    }
+    return "";
+  }
+
+  class SnapshotLoader {
+  public:
+    SnapshotLoader(const ATN &atn, SnapshotReader &reader)
+      : _atn(atn), _reader(reader), _isLexer(atn.grammarType == ATNType::LEXER) {
+    }
+
+    void readTables() {
+      _contexts.push_back(PredictionContext::EMPTY);
+      uint32_t count = _reader.next();
+      for (uint32_t i = 0; i < count; ++i) {
+        _contexts.push_back(readContext());
+      }
+
+      _semanticContexts.push_back(SemanticContext::NONE);
+      count = _reader.next();
+      for (uint32_t i = 0; i < count; ++i) {
+        _semanticContexts.push_back(readSemanticContext());
+      }
+
+      _executors.push_back(nullptr);
+      count = _reader.next();
+      for (uint32_t i = 0; i < count; ++i) {
+        _executors.push_back(readExecutor());
+      }
+    }
+
+    // The states of one DFA. They are owned by this object until release() is called.
+    struct LoadedDFA {
+      bool isPrecedenceDfa = false;
+      std::vector<std::unique_ptr<DFAState>> states; // The extra start state of a precedence DFA comes last.
+      DFAState *s0 = nullptr;
+      bool s0InStates = false;
+    };
+
+    void readDFA(LoadedDFA &result) {
+      result.isPrecedenceDfa = (_reader.next() & PRECEDENCE_DFA) != 0;
+      uint32_t stateCount = _reader.next();
+      uint32_t s0 = _reader.next();
+      if (s0 != NO_ID && s0 > stateCount) {
+        throw IllegalArgumentException("The DFA snapshot is damaged (invalid start state).");
+      }
+
+      size_t recordCount = stateCount + (s0 == stateCount ? 1 : 0);
+      std::vector<std::vector<uint32_t>> edges(recordCount);
+      std::vector<uint32_t> edgeTableSizes(recordCount);
+      for (size_t i = 0; i < recordCount; ++i) {
+        result.states.push_back(readState(edges[i], edgeTableSizes[i]));
+      }
+
+      for (size_t i = 0; i < recordCount; ++i) {
+        for (size_t j = 0; j < edges[i].size(); j += 2) {
+          uint32_t target = edges[i][j + 1];
+          if (target != ERROR_ID && target >= stateCount) {
+            throw IllegalArgumentException("The DFA snapshot is damaged (invalid edge target).");
+          }
+          DFAState *targetState = target == ERROR_ID ? ATNSimulator::ERROR.get() : result.states[target].get();
+          result.states[i]->setEdge(edges[i][j], targetState, edgeTableSizes[i]);
+        }
+      }
+
+      if (s0 != NO_ID) {
+        result.s0 = result.states[s0].get();
+        result.s0InStates = s0 < stateCount;
+      }
+    }
+
+  private:
+    const ATN &_atn;
+    SnapshotReader &_reader;
+    const bool _isLexer;
+
+    std::vector<IntrusivePtr<PredictionContext>> _contexts;
+    std::vector<Ref<SemanticContext>> _semanticContexts;
+    std::vector<Ref<LexerActionExecutor>> _executors;
+
+    IntrusivePtr<PredictionContext> getContext(uint32_t id, bool allowNull) {
+      if (id == NO_ID && allowNull) {
+        return nullptr;
+      }
+      if (id >= _contexts.size()) {
+        throw IllegalArgumentException("The DFA snapshot is damaged (invalid prediction context).");
+      }
+      return _contexts[id];
+    }
+
+    Ref<SemanticContext> getSemanticContext(uint32_t id) {
+      if (id >= _semanticContexts.size()) {
+        throw IllegalArgumentException("The DFA snapshot is damaged (invalid semantic context).");
+      }
+      return _semanticContexts[id];
+    }
+
+    IntrusivePtr<PredictionContext> readContext() {
+      uint32_t type = _reader.next();
+      switch (type) {
+        case SINGLETON_CONTEXT: {
+          IntrusivePtr<PredictionContext> parent = getContext(_reader.next(), true);
+          size_t returnState = fromReturnStateWord(_reader.next());
+          return SingletonPredictionContext::create(parent, returnState);
+        }
+
+        case ARRAY_CONTEXT: {
+          uint32_t size = _reader.next();
+          std::vector<IntrusivePtr<PredictionContext>> parents;
+          std::vector<size_t> returnStates;
+          for (uint32_t i = 0; i < size; ++i) {
+            parents.push_back(getContext(_reader.next(), true));
+            returnStates.push_back(fromReturnStateWord(_reader.next()));
+          }
+          if (parents.empty()) {
+            break;
+          }
+          return makeIntrusive<ArrayPredictionContext>(parents, returnStates);
+        }
+
+        default:
+          break;
+      }
+      throw IllegalArgumentException("The DFA snapshot is damaged (invalid prediction context).");
+    }
+
+    Ref<SemanticContext> readSemanticContext() {
+      uint32_t type = _reader.next();
+      switch (type) {
+        case PREDICATE: {
+          size_t ruleIndex = fromWord(_reader.next());
+          size_t predIndex = fromWord(_reader.next());
+          bool isCtxDependent = _reader.next() != 0;
+          return std::make_shared<SemanticContext::Predicate>(ruleIndex, predIndex, isCtxDependent);
+        }
+
+        case PRECEDENCE_PREDICATE:
+          return std::make_shared<SemanticContext::PrecedencePredicate>(static_cast<int>(_reader.next()));
+
+        case AND_CONTEXT:
+        case OR_CONTEXT: {
+          uint32_t count = _reader.next();
+          if (count == 0) {
+            break;
+          }
+
+          // The operators flatten nested operators of the same kind, so folding the operands gives the same set.
+          Ref<SemanticContext> result = getSemanticContext(_reader.next());
+          Ref<SemanticContext> first = result;
+          for (uint32_t i = 1; i < count; ++i) {
+            Ref<SemanticContext> operand = getSemanticContext(_reader.next());
+            if (type == AND_CONTEXT) {
+              result = std::make_shared<SemanticContext::AND>(result, operand);
+            } else {
+              result = std::make_shared<SemanticContext::OR>(result, operand);
+            }
+          }
+          if (count == 1) {
+            if (type == AND_CONTEXT) {
+              result = std::make_shared<SemanticContext::AND>(first, first);
+            } else {
+              result = std::make_shared<SemanticContext::OR>(first, first);
+            }
+          }
+          return result;
+        }
+
+        default:
+          break;
+      }
+      throw IllegalArgumentException("The DFA snapshot is damaged (invalid semantic context).");
+    }
+
+    Ref<LexerActionExecutor> readExecutor() {
+      uint32_t count = _reader.next();
+      std::vector<Ref<LexerAction>> actions;
+      for (uint32_t i = 0; i < count; ++i) {
+        uint32_t kind = _reader.next();
+        int offset = static_cast<int>(_reader.next());
+        Ref<LexerAction> action = _atn.lexerActions[_reader.next(_atn.lexerActions.size(), "lexer action")];
+        if (kind == INDEXED_CUSTOM_ACTION) {
+          actions.push_back(std::make_shared<LexerIndexedCustomAction>(offset, action));
+        } else {
+          actions.push_back(action);
+        }
+      }
+      return std::make_shared<LexerActionExecutor>(actions);
+    }
+
+    std::unique_ptr<ATNConfigSet> readConfigs() {
+      uint32_t count = _reader.next();
+      if (count == NO_ID) {
+        return nullptr;
+      }
+
+      uint32_t flags = _reader.next();
+      std::unique_ptr<ATNConfigSet> configs;
+      if (_isLexer) {
+        configs.reset(new OrderedATNConfigSet());
+      } else {
+        configs.reset(new ATNConfigSet((flags & FULL_CONTEXT) != 0));
+      }
+      configs->uniqueAlt = fromWord(_reader.next());
+
+      uint32_t conflictingAltCount = _reader.next();
+      for (uint32_t i = 0; i < conflictingAltCount; ++i) {
+        configs->conflictingAlts.set(_reader.next(configs->conflictingAlts.size(), "alternative"));
+      }
+
+      // The configurations are unique already, so they go directly into the list without lookup or merging.
+      for (uint32_t i = 0; i < count; ++i) {
+        ATNState *state = _atn.states[_reader.next(_atn.states.size(), "ATN state")];
+        if (state == nullptr) {
+          throw IllegalArgumentException("The DFA snapshot is damaged (invalid ATN state).");
+        }
+        size_t alt = fromWord(_reader.next());
+        IntrusivePtr<PredictionContext> context = getContext(_reader.next(), false);
+        Ref<SemanticContext> semanticContext = getSemanticContext(_reader.next());
+        size_t reachesIntoOuterContext = fromWord(_reader.next());
+
+        Ref<ATNConfig> config;
+        if (_isLexer) {
+          uint32_t executor = _reader.next(_executors.size(), "lexer action executor");
+          bool passedThroughNonGreedyDecision = _reader.next() != 0;
+          config = std::make_shared<LexerATNConfig>(state, static_cast<int>(alt), context, _executors[executor],
+                                                    passedThroughNonGreedyDecision);
+        } else {
+          config = std::make_shared<ATNConfig>(state, alt, context, semanticContext);
+        }
+        config->reachesIntoOuterContext = reachesIntoOuterContext;
+        configs->configs.push_back(config);
+      }
+
+      configs->hasSemanticContext = (flags & HAS_SEMANTIC_CONTEXT) != 0;
+      configs->dipsIntoOuterContext = (flags & DIPS_INTO_OUTER_CONTEXT) != 0;
+      configs->setReadonly(true);
+      return configs;
+    }
+
+    std::unique_ptr<DFAState> readState(std::vector<uint32_t> &edges, uint32_t &edgeTableSize) {
+      std::unique_ptr<DFAState> state(new DFAState());
+      state->stateNumber = static_cast<int>(_reader.next());
+      uint32_t flags = _reader.next();
+      state->isAcceptState = (flags & ACCEPT_STATE) != 0;
+      state->requiresFullContext = (flags & REQUIRES_FULL_CONTEXT) != 0;
+      state->prediction = fromWord(_reader.next());
+      state->lexerActionExecutor = _executors[_reader.next(_executors.size(), "lexer action executor")];
+
+      uint32_t predicateCount = _reader.next();
+      for (uint32_t i = 0; i < predicateCount; ++i) {
+        Ref<SemanticContext> predicate = getSemanticContext(_reader.next());
+        int alt = static_cast<int>(_reader.next());
+        state->predicates.push_back(new DFAState::PredPrediction(predicate, alt)); /* mem-check: deleted by the DFA state */
+      }
+
+      state->configs = readConfigs();
+
+      edgeTableSize = _reader.next(MAX_EDGE_TABLE_SIZE + 1, "edge table size");
+      uint32_t edgeCount = _reader.next(edgeTableSize + 1, "edge count");
+      for (uint32_t i = 0; i < edgeCount; ++i) {
+        edges.push_back(_reader.next(edgeTableSize, "edge symbol"));
+        edges.push_back(_reader.next());
+      }
+      return state;
+    }
+  };
+
+}
+
+std::string DFASnapshot::serialize(const ATN &atn, std::vector<DFA> &decisionToDFA) {
+  SnapshotWriter writer(atn);
+  for (auto &dfa : decisionToDFA) {
+    writer.writeDFA(dfa);
+  }
+  return writer.getResult(decisionToDFA.size());
+}
+
+bool DFASnapshot::isCompatible(const ATN &atn, const char *data, size_t size) {
+  SnapshotReader reader(data, size);
+  try {
+    return checkHeader(reader, atn).empty();
+  } catch (IllegalArgumentException &) {
+    return false;
+  }
+}
+
+void DFASnapshot::deserialize(const ATN &atn, std::vector<DFA> &decisionToDFA, const char *data, size_t size) {
+  SnapshotReader reader(data, size);
+  std::string reason = checkHeader(reader, atn);
+  if (!reason.empty()) {
+    throw UnsupportedOperationException(reason);
+  }
+  if (decisionToDFA.size() != atn.getNumberOfDecisions()) {
+    throw IllegalArgumentException("The DFA list does not belong to the ATN of the snapshot.");
+  }
+  for (auto &dfa : decisionToDFA) {
+    if (!dfa.states.empty() || (dfa.s0 != nullptr && !dfa.isPrecedenceDfa())) {
+      throw IllegalStateException("DFA snapshots can only be loaded into empty DFAs.");
+    }
+  }
+
+  // Everything is read before the first DFA is touched, so a damaged snapshot leaves the DFAs empty.
+  SnapshotLoader loader(atn, reader);
+  loader.readTables();
+  std::vector<SnapshotLoader::LoadedDFA> loaded(decisionToDFA.size());
+  for (size_t i = 0; i < loaded.size(); ++i) {
+    loader.readDFA(loaded[i]);
+    if (loaded[i].isPrecedenceDfa != decisionToDFA[i].isPrecedenceDfa() ||
+        (loaded[i].isPrecedenceDfa && loaded[i].s0 != nullptr && loaded[i].s0InStates)) {
+      throw IllegalArgumentException("The DFA snapshot is damaged (invalid start state).");
+    }
+  }
+  if (!reader.atEnd()) {
+    throw IllegalArgumentException("The DFA snapshot is damaged (unexpected trailing data).");
+  }
+
+  bool isParser = atn.grammarType == ATNType::PARSER;
+  for (size_t i = 0; i < loaded.size(); ++i) {
+    DFA &dfa = decisionToDFA[i];
+    SnapshotLoader::LoadedDFA &source = loaded[i];
+
+    std::unique_lock<std::mutex> lock { dfa.getStateLock() };
+    for (auto &state : source.states) {
+      DFAState *released = state.release();
+      if (released == source.s0 && !source.s0InStates) {
+        // Replaces the empty precedence start state created by the DFA constructor.
+        delete dfa.s0.exchange(released, std::memory_order_acq_rel);
+        continue;
+      }
+
+      dfa.states.insert(released);
+      if (isParser && released->configs != nullptr) {
+        dfa.addMemoryUsage(ParserATNSimulator::estimateDFAStateMemory(atn, released));
+      }
+    }
+    if (source.s0InStates) {
+      dfa.s0.store(source.s0, std::memory_order_release);
+    }
+  }
+}
@@ -0,0 +1,43 @@
+/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#pragma once
+
+#include "dfa/DFA.h"
+
+namespace antlr4 {
+namespace dfa {
+
+  /// Saves the DFAs of a lexer or parser in a binary form and loads them again, so that a new process can start
+  /// with the DFA warmed up by an earlier one instead of building it again through full ATN simulation.
+  ///
+  /// A snapshot contains the DFA states with their configurations, the prediction contexts, semantic contexts and
+  /// lexer action executors these refer to, and the DFA edges. ATN states and lexer actions are stored as indexes
+  /// into the ATN, so a snapshot can only be loaded for the same ATN it was taken from. It starts with a
+  /// fingerprint of the ATN (and of the compile time DFA settings), and deserialize() refuses snapshots with a
+  /// different fingerprint.
+  ///
+  /// The data is a flat sequence of 32 bit words in the byte order of the machine that wrote it. deserialize()
+  /// reads it in place, so it can be passed a memory mapped snapshot file.
+  class ANTLR4CPP_PUBLIC DFASnapshot {
+  public:
+    /// Returns a snapshot of {@code decisionToDFA}, the DFAs of a recognizer using {@code atn}. Other threads may
+    /// keep predicting with the DFAs meanwhile, each DFA is locked while it is written.
+    static std::string serialize(const atn::ATN &atn, std::vector<DFA> &decisionToDFA);
+
+    /// Returns true if the snapshot in {@code data} was taken from {@code atn} and can be loaded for it.
+    static bool isCompatible(const atn::ATN &atn, const char *data, size_t size);
+
+    /// Loads the snapshot in {@code data} into {@code decisionToDFA}, whose DFAs must be empty. No simulator may use
+    /// them while this runs.
+    ///
+    /// @throws UnsupportedOperationException if the snapshot was taken from a different ATN.
+    /// @throws IllegalArgumentException if the snapshot is damaged.
+    /// @throws IllegalStateException if a DFA is not empty.
+    static void deserialize(const atn::ATN &atn, std::vector<DFA> &decisionToDFA, const char *data, size_t size);
+  };
+
+} // namespace atn
+} // namespace antlr4
@@ -45,6 +45,7 @@ DFAState::~DFAState() {
   for (auto *predicate : predicates) {
     delete predicate;
   }
+  delete _edges.load();
 }
 
 std::set<size_t> DFAState::getAltSet() {
@@ -73,6 +74,38 @@ bool DFAState::operator == (const DFAState &o) const {
   return *configs == *o.configs;
 }
 
+void DFAState::setEdge(size_t symbol, DFAState *target, size_t minSize) {
+  EdgeTable *table = _edges.load(std::memory_order_acquire);
+  while (table == nullptr || symbol >= table->size) {
+    size_t size = std::max(symbol + 1, minSize);
+    if (table != nullptr) {
+      size = std::max(size, 2 * table->size);
+    }
+
+    EdgeTable *grown = new EdgeTable(size, table); /* mem-check: owned by this state once published, deleted below otherwise */
+    if (table != nullptr) {
+      for (size_t i = 0; i < table->size; ++i) {
+        grown->slots[i].store(table->slots[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      }
+    }
+
+    if (_edges.compare_exchange_strong(table, grown, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      table = grown;
+    } else {
+      // Another thread published a table in the meantime (now in "table"). Try again with that one.
+      grown->previous = nullptr;
+      delete grown;
+    }
+  }
+
+  table->slots[symbol].store(target, std::memory_order_release);
+}
+
+size_t DFAState::getEdgeCount() const {
+  EdgeTable *table = _edges.load(std::memory_order_acquire);
+  return table == nullptr ? 0 : table->size;
+}
+
 std::string DFAState::toString() {
   std::stringstream ss;
   ss << stateNumber;
@@ -92,7 +125,20 @@ std::string DFAState::toString() {
   return ss.str();
 }
 
+DFAState::EdgeTable::EdgeTable(size_t size, EdgeTable *previous) : size(size), previous(previous) {
+  slots = new std::atomic<DFAState *>[size];
+  for (size_t i = 0; i < size; ++i) {
+    std::atomic_init(&slots[i], static_cast<DFAState *>(nullptr));
+  }
+}
+
+DFAState::EdgeTable::~EdgeTable() {
+  delete[] slots;
+  delete previous;
+}
+
 void DFAState::InitializeInstanceFields() {
+  std::atomic_init(&_edges, static_cast<EdgeTable *>(nullptr));
   stateNumber = -1;
   isAcceptState = false;
   prediction = 0;
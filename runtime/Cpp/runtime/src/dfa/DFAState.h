@@ -55,12 +55,6 @@ namespace dfa {
 
     std::unique_ptr<atn::ATNConfigSet> configs;
 
-    /// {@code edges[symbol]} points to target of symbol. Shift up by 1 so (-1)
-    ///  <seealso cref="Token#EOF"/> maps to {@code edges[0]}.
-    // ml: this is a sparse list, so we use a map instead of a vector.
-    //     Watch out: we no longer have the -1 offset, as it isn't needed anymore.
-    std::unordered_map<size_t, DFAState *> edges;
-
     bool isAcceptState;
 
     /// if accept state, what ttype do we match or alt do we predict?
@@ -122,6 +116,25 @@ namespace dfa {
 
     virtual std::string toString();
 
+    /// {@code getEdge(symbol)} points to the target of symbol. The parser shifts symbols up by 1 so (-1)
+    /// <seealso cref="Token#EOF"/> maps to edge 0.
+    ///
+    /// Lookups take no lock. They can run concurrently with setEdge() from other threads and return either
+    /// null or a fully constructed target state.
+    DFAState* getEdge(size_t symbol) const;
+
+    /// Connects this state to {@code target} upon {@code symbol}. When the edge table must be created or grown
+    /// a larger copy is published atomically and the old table is kept until this state is destroyed, so
+    /// concurrent readers never touch freed memory. An edge added by another thread while the table is
+    /// being copied may get lost, which only means it is computed again later.
+    ///
+    /// @param minSize The number of slots to allocate when a new table is needed. Passing the full symbol
+    ///                range avoids growing the table repeatedly.
+    void setEdge(size_t symbol, DFAState *target, size_t minSize = 0);
+
+    /// The number of edge slots currently allocated, for iteration with getEdge().
+    size_t getEdgeCount() const;
+
     struct Hasher
     {
       size_t operator()(DFAState *k) const {
@@ -137,8 +150,26 @@ namespace dfa {
     };
 
   private:
+    struct EdgeTable {
+      EdgeTable(size_t size, EdgeTable *previous);
+      ~EdgeTable();
+
+      const size_t size;
+      std::atomic<DFAState *> *slots;
+      EdgeTable *previous; // The (smaller) table this one replaced.
+    };
+
+    std::atomic<EdgeTable *> _edges;
+
     void InitializeInstanceFields();
   };
 
+  inline DFAState* DFAState::getEdge(size_t symbol) const {
+    EdgeTable *table = _edges.load(std::memory_order_acquire);
+    if (table == nullptr || symbol >= table->size)
+      return nullptr;
+    return table->slots[symbol].load(std::memory_order_acquire);
+  }
+
 } // namespace atn
 } // namespace antlr4
@@ -4,6 +4,8 @@
  */
 
 #include "Vocabulary.h"
+#include "support/StringUtils.h"
+#include "atn/LexerATNSimulator.h"
 
 #include "dfa/LexerDFASerializer.h"
 
@@ -16,5 +18,12 @@ LexerDFASerializer::~LexerDFASerializer() {
 }
 
 std::string LexerDFASerializer::getEdgeLabel(size_t i) const {
-  return std::string("'") + static_cast<char>(i) + "'";
+  // Edges behind the direct range stand for a whole class of code points.
+  if (i > atn::LexerATNSimulator::MAX_DFA_EDGE - atn::LexerATNSimulator::MIN_DFA_EDGE) {
+    return "{class " + std::to_string(i - (atn::LexerATNSimulator::MAX_DFA_EDGE - atn::LexerATNSimulator::MIN_DFA_EDGE + 1)) + "}";
+  }
+
+  // Edges above 127 exist only if the runtime was compiled with a larger ANTLR4CPP_LEXER_MAX_DFA_EDGE.
+  i += atn::LexerATNSimulator::MIN_DFA_EDGE;
+  return std::string("'") + antlrcpp::utf32_to_utf8(UTF32String(1, static_cast<UTF32String::value_type>(i))) + "'";
 }
@@ -9,6 +9,8 @@
 
 #include "antlr4-common.h"
 
+#include <new>
+
 #ifdef _MSC_VER
   #pragma warning(push)
   #pragma warning(disable: 4521) // 'antlrcpp::Any': multiple copy constructors specified
@@ -27,21 +29,20 @@ struct ANTLR4CPP_PUBLIC Any
   Any() : _ptr(nullptr) {
   }
 
-  Any(Any& that) : _ptr(that.clone()) {
+  Any(Any& that) : _ptr(that.clone(&_buffer)) {
   }
 
-  Any(Any&& that) : _ptr(that._ptr) {
-    that._ptr = nullptr;
+  Any(Any&& that) : _ptr(that.release(&_buffer)) {
   }
 
-  Any(const Any& that) : _ptr(that.clone()) {
+  Any(const Any& that) : _ptr(that.clone(&_buffer)) {
   }
 
-  Any(const Any&& that) : _ptr(that.clone()) {
+  Any(const Any&& that) : _ptr(that.clone(&_buffer)) {
   }
 
   template<typename U>
-  Any(U&& value) : _ptr(new Derived<StorageType<U>>(std::forward<U>(value))) {
+  Any(U&& value) : _ptr(create<StorageType<U>>(&_buffer, std::forward<U>(value))) {
   }
 
   template<class U>
@@ -51,6 +52,9 @@ struct ANTLR4CPP_PUBLIC Any
     return derived != nullptr;
   }
 
+  /// Returns a reference to the stored value. For numbers and other small trivially copyable values the reference
+  /// points into this Any and is invalidated when the Any is moved or destroyed, so copy such values out instead
+  /// of keeping the reference.
   template<class U>
   StorageType<U>& as() {
     auto derived = getDerived<U>(true);
@@ -79,20 +83,18 @@ struct ANTLR4CPP_PUBLIC Any
     if (_ptr == a._ptr)
       return *this;
 
-    auto * old_ptr = _ptr;
-    _ptr = a.clone();
-
-    if (old_ptr)
-      delete old_ptr;
-
-    return *this;
+    Any copy(a);
+    return *this = std::move(copy);
   }
 
   Any& operator = (Any&& a) {
     if (_ptr == a._ptr)
       return *this;
 
-    std::swap(_ptr, a._ptr);
+    // Take the value first, a might be owned by the value this Any holds.
+    Any value(std::move(a));
+    destroy();
+    _ptr = value.release(&_buffer);
 
     return *this;
   }
@@ -104,9 +106,29 @@ struct ANTLR4CPP_PUBLIC Any
   }
 
 private:
+  /// Trivially copyable values up to this size (numbers, raw pointers) are stored in the Any itself, so that they do
+  /// not need a heap allocation. This matters for visitors, which return an Any from every visit call. All other
+  /// values live on the heap, so references to them stay valid when the Any is moved.
+  static constexpr size_t BufferSize = 4 * sizeof(void *);
+
+  typedef typename std::aligned_storage<BufferSize, alignof(void *)>::type Buffer;
+
   struct Base {
     virtual ~Base() {};
-    virtual Base* clone() const = 0;
+
+    /// Copies the value into buffer if it fits, otherwise to the heap. Returns null if the value cannot be copied.
+    virtual Base* clone(void *buffer) const = 0;
+
+    /// Moves a value stored inline to buffer and destroys this one. Heap values stay where they are.
+    virtual Base* move(void *buffer) = 0;
+
+    virtual void destroy() = 0;
+  };
+
+  /// Derived<T> adds a vtable pointer to the value.
+  template<typename T>
+  struct IsInline : std::integral_constant<bool, sizeof(T) + sizeof(Base) <= sizeof(Buffer) &&
+    alignof(T) <= alignof(Buffer) && std::is_trivially_copyable<T>::value> {
   };
 
   template<typename T>
@@ -117,31 +139,91 @@ private:
 
     T value;
 
-    Base* clone() const {
-      return clone<>();
+    Base* clone(void *buffer) const {
+      return clone<>(buffer);
+    }
+
+    Base* move(void *buffer) {
+      return move<>(buffer);
+    }
+
+    void destroy() {
+      destroy<>();
     }
 
   private:
     template<int N = 0, typename std::enable_if<N == N && std::is_nothrow_copy_constructible<T>::value, int>::type = 0>
-    Base* clone() const {
-      return new Derived<T>(value);
+    Base* clone(void *buffer) const {
+      return create<T>(buffer, value);
     }
 
     template<int N = 0, typename std::enable_if<N == N && !std::is_nothrow_copy_constructible<T>::value, int>::type = 0>
-    Base* clone() const {
+    Base* clone(void * /*buffer*/) const {
       return nullptr;
     }
 
+    template<int N = 0, typename std::enable_if<N == N && IsInline<T>::value, int>::type = 0>
+    Base* move(void *buffer) {
+      Base *result = new (buffer) Derived<T>(std::move(value));
+      this->~Derived();
+      return result;
+    }
+
+    template<int N = 0, typename std::enable_if<N == N && !IsInline<T>::value, int>::type = 0>
+    Base* move(void * /*buffer*/) {
+      return this;
+    }
+
+    template<int N = 0, typename std::enable_if<N == N && IsInline<T>::value, int>::type = 0>
+    void destroy() {
+      this->~Derived();
+    }
+
+    template<int N = 0, typename std::enable_if<N == N && !IsInline<T>::value, int>::type = 0>
+    void destroy() {
+      delete this;
+    }
+
   };
 
-  Base* clone() const
+  template<typename T, typename U, typename std::enable_if<IsInline<T>::value, int>::type = 0>
+  static Base* create(void *buffer, U&& value) {
+    static_assert(sizeof(Derived<T>) <= sizeof(Buffer), "value does not fit into the buffer");
+    return new (buffer) Derived<T>(std::forward<U>(value));
+  }
+
+  template<typename T, typename U, typename std::enable_if<!IsInline<T>::value, int>::type = 0>
+  static Base* create(void * /*buffer*/, U&& value) {
+    return new Derived<T>(std::forward<U>(value)); /* mem-check: deleted by Derived::destroy() */
+  }
+
+  Base* clone(void *buffer) const
   {
     if (_ptr)
-      return _ptr->clone();
+      return _ptr->clone(buffer);
     else
       return nullptr;
   }
 
+  // Moves the value to buffer (if it is stored inline) and leaves this Any empty.
+  Base* release(void *buffer)
+  {
+    Base *result = nullptr;
+    if (_ptr) {
+      result = _ptr->move(buffer);
+      _ptr = nullptr;
+    }
+    return result;
+  }
+
+  void destroy()
+  {
+    if (_ptr) {
+      _ptr->destroy();
+      _ptr = nullptr;
+    }
+  }
+
   template<class U>
   Derived<StorageType<U>>* getDerived(bool checkCast) const {
     typedef StorageType<U> T;
@@ -155,6 +237,7 @@ private:
   }
 
   Base *_ptr;
+  Buffer _buffer;
 
 };
 
@@ -0,0 +1,95 @@
+/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#include "support/Arena.h"
+
+using namespace antlrcpp;
+
+namespace {
+
+  // Every allocation is preceded by a pointer to its chunk, so deallocate() needs no arena.
+  const size_t HEADER_SIZE = sizeof(void *);
+
+  size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+  }
+
+}
+
+struct Arena::Chunk {
+  Chunk(size_t size_) : size(size_), references(1), data(new char[size_]) {
+  }
+
+  ~Chunk() {
+    delete[] data;
+  }
+
+  void release() {
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+  const size_t size;
+
+  // One for each live allocation, plus one while the chunk is the current chunk of its arena.
+  std::atomic<size_t> references;
+
+  char *const data;
+};
+
+Arena::Arena(size_t chunkSize) : _chunkSize(chunkSize), _current(nullptr), _offset(0) {
+}
+
+Arena::~Arena() {
+  if (_current != nullptr) {
+    _current->release();
+  }
+}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+  alignment = std::max(alignment, alignof(Chunk *));
+
+  size_t address = 0;
+  if (_current != nullptr) {
+    size_t base = reinterpret_cast<size_t>(_current->data);
+    address = alignUp(base + _offset + HEADER_SIZE, alignment);
+    if (address + size > base + _current->size) {
+      _current->release();
+      _current = nullptr;
+    }
+  }
+
+  if (_current == nullptr) {
+    // Oversized requests get a chunk of their own.
+    _current = new Chunk(std::max(_chunkSize, HEADER_SIZE + size + alignment)); /* mem-check: deleted by release() */
+    address = alignUp(reinterpret_cast<size_t>(_current->data) + HEADER_SIZE, alignment);
+  }
+
+  char *result = reinterpret_cast<char *>(address);
+  reinterpret_cast<Chunk **>(result)[-1] = _current;
+  _current->references.fetch_add(1, std::memory_order_relaxed);
+  _offset = address + size - reinterpret_cast<size_t>(_current->data);
+
+  return result;
+}
+
+void Arena::deallocate(void *p) {
+  if (p != nullptr) {
+    reinterpret_cast<Chunk **>(p)[-1]->release();
+  }
+}
+
+void Arena::reset() {
+  if (_current == nullptr) {
+    return;
+  }
+
+  if (_current->references.load(std::memory_order_acquire) > 1) {
+    _current->release();
+    _current = nullptr;
+  }
+  _offset = 0;
+}
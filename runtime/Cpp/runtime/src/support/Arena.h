@@ -0,0 +1,79 @@
+/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#pragma once
+
+#include "antlr4-common.h"
+
+namespace antlrcpp {
+
+  /// A bump allocator for many small, short-lived objects. Memory is handed out from large chunks, each of which
+  /// counts its live allocations. A chunk is freed once the arena has moved on from it and its last allocation was
+  /// released, so allocations may outlive the arena and may be released from any thread.
+  ///
+  /// The arena itself is not thread-safe: only one thread may allocate from it at a time.
+  class ANTLR4CPP_PUBLIC Arena {
+  public:
+    explicit Arena(size_t chunkSize = 64 * 1024);
+    Arena(const Arena &) = delete;
+    ~Arena();
+
+    Arena& operator = (const Arena &) = delete;
+
+    void* allocate(size_t size, size_t alignment);
+
+    /// Releases memory returned by allocate() of any arena.
+    static void deallocate(void *p);
+
+    /// Makes the memory of the current chunk available again if none of its allocations is still alive.
+    /// Otherwise the next allocation starts a new chunk. Call this when a batch of temporary objects is gone.
+    void reset();
+
+  private:
+    struct Chunk;
+
+    const size_t _chunkSize;
+    Chunk *_current;
+    size_t _offset;
+  };
+
+  /// A standard allocator for an Arena, e.g. for std::allocate_shared.
+  template <typename T>
+  class ArenaAllocator {
+  public:
+    typedef T value_type;
+
+    ArenaAllocator(Arena &arena) : _arena(&arena) {
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : _arena(other._arena) {
+    }
+
+    T* allocate(size_t n) {
+      return static_cast<T *>(_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, size_t /*n*/) {
+      Arena::deallocate(p);
+    }
+
+    template <typename U>
+    bool operator == (const ArenaAllocator<U> &other) const {
+      return _arena == other._arena;
+    }
+
+    template <typename U>
+    bool operator != (const ArenaAllocator<U> &other) const {
+      return _arena != other._arena;
+    }
+
+  private:
+    template <typename U> friend class ArenaAllocator;
+
+    Arena *_arena;
+  };
+
+} // namespace antlrcpp
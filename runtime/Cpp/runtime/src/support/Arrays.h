@@ -6,6 +6,7 @@
 #pragma once
 
 #include "antlr4-common.h"
+#include "support/IntrusivePtr.h"
 
 namespace antlrcpp {
 
@@ -61,6 +62,26 @@ namespace antlrcpp {
       return true;
     }
 
+    template <typename T>
+    static bool equals(const std::vector<IntrusivePtr<T>> &a, const std::vector<IntrusivePtr<T>> &b) {
+      if (a.size() != b.size())
+        return false;
+
+      for (size_t i = 0; i < a.size(); ++i) {
+        if (!a[i] && !b[i])
+          continue;
+        if (!a[i] || !b[i])
+          return false;
+        if (a[i] == b[i])
+          continue;
+
+        if (!(*a[i] == *b[i]))
+          return false;
+      }
+
+      return true;
+    }
+
     template <typename T>
     static std::string toString(const std::vector<T> &source) {
       std::string result = "[";
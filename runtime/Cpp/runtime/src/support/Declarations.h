@@ -30,6 +30,7 @@ namespace antlr4 {
   class Lexer;
   class LexerInterpreter;
   class LexerNoViableAltException;
+  class LineIndex;
   class ListTokenSource;
   class NoSuchElementException;
   class NoViableAltException;
@@ -45,6 +46,7 @@ namespace antlr4 {
   class Token;
   template<typename Symbol> class TokenFactory;
   class TokenSource;
+  class TokenStore;
   class TokenStream;
   class TokenStreamRewriter;
   class UnbufferedCharStream;
@@ -77,6 +79,7 @@ namespace antlr4 {
     class BasicState;
     class BlockEndState;
     class BlockStartState;
+    class CharClassMap;
     class DecisionState;
     class EmptyPredictionContext;
     class EpsilonTransition;
@@ -124,9 +127,12 @@ namespace antlr4 {
   }
   namespace tree {
     class AbstractParseTreeVisitor;
+    template<typename T> class DenseParseTreeProperty;
     class ErrorNode;
     class ErrorNodeImpl;
+    class FlatParseTree;
     class ParseTree;
+    class ParseTreeArena;
     class ParseTreeListener;
     template<typename T> class ParseTreeProperty;
     class ParseTreeVisitor;
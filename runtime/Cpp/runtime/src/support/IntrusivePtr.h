@@ -0,0 +1,170 @@
+/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#pragma once
+
+#include "antlr4-common.h"
+
+namespace antlrcpp {
+
+  /// Base class for objects shared through IntrusivePtr. The reference count is part of the object, so unlike
+  /// with std::shared_ptr there is no separate control block to allocate, and a pointer is a single raw pointer.
+  class ANTLR4CPP_PUBLIC IntrusiveRefCounted {
+  public:
+    IntrusiveRefCounted() : _references(0) {
+    }
+
+    IntrusiveRefCounted(const IntrusiveRefCounted &) : _references(0) {
+    }
+
+    virtual ~IntrusiveRefCounted() {
+    }
+
+    IntrusiveRefCounted& operator = (const IntrusiveRefCounted &) {
+      return *this;
+    }
+
+    void addReference() const {
+      _references.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// The number of references, which may already be outdated when other threads hold references too.
+    size_t getReferenceCount() const {
+      return _references.load(std::memory_order_relaxed);
+    }
+
+    /// Deletes the object when the last reference is released.
+    void releaseReference() const {
+      if (_references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+      }
+    }
+
+  private:
+    mutable std::atomic<size_t> _references;
+  };
+
+  /// A shared pointer to an object derived from IntrusiveRefCounted, with the interface of std::shared_ptr
+  /// as far as the runtime needs it.
+  template <typename T>
+  class IntrusivePtr {
+  public:
+    typedef T element_type;
+
+    IntrusivePtr() : _pointer(nullptr) {
+    }
+
+    IntrusivePtr(std::nullptr_t) : _pointer(nullptr) {
+    }
+
+    explicit IntrusivePtr(T *pointer) : _pointer(pointer) {
+      if (_pointer != nullptr) {
+        _pointer->addReference();
+      }
+    }
+
+    IntrusivePtr(const IntrusivePtr &other) : IntrusivePtr(other._pointer) {
+    }
+
+    IntrusivePtr(IntrusivePtr &&other) : _pointer(other._pointer) {
+      other._pointer = nullptr;
+    }
+
+    template <typename U, typename = typename std::enable_if<std::is_convertible<U *, T *>::value>::type>
+    IntrusivePtr(const IntrusivePtr<U> &other) : IntrusivePtr(other.get()) {
+    }
+
+    template <typename U, typename = typename std::enable_if<std::is_convertible<U *, T *>::value>::type>
+    IntrusivePtr(IntrusivePtr<U> &&other) : _pointer(other._pointer) {
+      other._pointer = nullptr;
+    }
+
+    ~IntrusivePtr() {
+      if (_pointer != nullptr) {
+        _pointer->releaseReference();
+      }
+    }
+
+    IntrusivePtr& operator = (IntrusivePtr other) {
+      swap(other);
+      return *this;
+    }
+
+    T* get() const {
+      return _pointer;
+    }
+
+    T& operator * () const {
+      return *_pointer;
+    }
+
+    T* operator -> () const {
+      return _pointer;
+    }
+
+    explicit operator bool () const {
+      return _pointer != nullptr;
+    }
+
+    void reset() {
+      IntrusivePtr().swap(*this);
+    }
+
+    void swap(IntrusivePtr &other) {
+      std::swap(_pointer, other._pointer);
+    }
+
+  private:
+    template <typename U> friend class IntrusivePtr;
+
+    T *_pointer;
+  };
+
+  template <typename T, typename... Args>
+  IntrusivePtr<T> makeIntrusive(Args&&... args) {
+    return IntrusivePtr<T>(new T(std::forward<Args>(args)...)); /* mem-check: deleted with the last reference */
+  }
+
+  template <typename T, typename U>
+  IntrusivePtr<T> static_pointer_cast(const IntrusivePtr<U> &pointer) {
+    return IntrusivePtr<T>(static_cast<T *>(pointer.get()));
+  }
+
+  template <typename T, typename U>
+  IntrusivePtr<T> dynamic_pointer_cast(const IntrusivePtr<U> &pointer) {
+    return IntrusivePtr<T>(dynamic_cast<T *>(pointer.get()));
+  }
+
+  template <typename T1, typename T2>
+  inline bool is(IntrusivePtr<T2> const& obj) {
+    return dynamic_cast<T1 *>(obj.get()) != nullptr;
+  }
+
+  template <typename T, typename U>
+  bool operator == (const IntrusivePtr<T> &lhs, const IntrusivePtr<U> &rhs) {
+    return lhs.get() == rhs.get();
+  }
+
+  template <typename T, typename U>
+  bool operator != (const IntrusivePtr<T> &lhs, const IntrusivePtr<U> &rhs) {
+    return lhs.get() != rhs.get();
+  }
+
+  template <typename T>
+  bool operator == (const IntrusivePtr<T> &lhs, std::nullptr_t) {
+    return lhs.get() == nullptr;
+  }
+
+  template <typename T>
+  bool operator != (const IntrusivePtr<T> &lhs, std::nullptr_t) {
+    return lhs.get() != nullptr;
+  }
+
+  template <typename T>
+  bool operator < (const IntrusivePtr<T> &lhs, const IntrusivePtr<T> &rhs) {
+    return std::less<T *>()(lhs.get(), rhs.get());
+  }
+
+} // namespace antlrcpp
@@ -0,0 +1,105 @@
+/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#pragma once
+
+#include "antlr4-common.h"
+
+#include <cstring>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+namespace antlrcpp {
+
+  /// A non-owning reference to a range of chars. It supports the part of the std::string_view interface which the
+  /// runtime uses. This is the same type in every language mode, because it is part of virtual interfaces (like
+  /// Token::getTextView()) and the runtime may be built with another standard than the application. C++17 code can
+  /// convert it to std::string_view.
+  class ANTLR4CPP_PUBLIC StringView {
+  public:
+    typedef const char *const_iterator;
+
+    StringView() : _data(nullptr), _size(0) {
+    }
+
+    StringView(const char *data, size_t size) : _data(data), _size(size) {
+    }
+
+    StringView(const char *text) : _data(text), _size(std::strlen(text)) {
+    }
+
+    StringView(const std::string &text) : _data(text.data()), _size(text.size()) {
+    }
+
+    explicit operator std::string() const {
+      return std::string(_data, _size);
+    }
+
+#if __cplusplus >= 201703L
+    operator std::string_view() const {
+      return std::string_view(_data, _size);
+    }
+#endif
+
+    const char* data() const {
+      return _data;
+    }
+
+    size_t size() const {
+      return _size;
+    }
+
+    size_t length() const {
+      return _size;
+    }
+
+    bool empty() const {
+      return _size == 0;
+    }
+
+    const_iterator begin() const {
+      return _data;
+    }
+
+    const_iterator end() const {
+      return _data + _size;
+    }
+
+    char operator [] (size_t index) const {
+      return _data[index];
+    }
+
+    int compare(StringView other) const {
+      int result = _size == 0 || other._size == 0 ? 0 : std::memcmp(_data, other._data, std::min(_size, other._size));
+      if (result != 0) {
+        return result;
+      }
+      return _size < other._size ? -1 : (_size > other._size ? 1 : 0);
+    }
+
+  private:
+    const char *_data;
+    size_t _size;
+  };
+
+  inline bool operator == (StringView lhs, StringView rhs) {
+    return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+  }
+
+  inline bool operator != (StringView lhs, StringView rhs) {
+    return !(lhs == rhs);
+  }
+
+  inline bool operator < (StringView lhs, StringView rhs) {
+    return lhs.compare(rhs) < 0;
+  }
+
+  inline std::ostream& operator << (std::ostream &stream, StringView text) {
+    return stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+  }
+
+} // namespace antlrcpp
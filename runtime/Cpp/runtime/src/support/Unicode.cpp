@@ -0,0 +1,469 @@
+/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#include "support/Unicode.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+  #define ANTLR4_UNICODE_X64
+  #include <immintrin.h>
+  #ifdef _MSC_VER
+    #include <intrin.h>
+  #endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+  #define ANTLR4_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+  #define ANTLR4_TARGET_AVX2
+#endif
+
+using namespace antlrcpp;
+
+namespace {
+
+  typedef UTF32String::value_type Utf32Unit;
+
+  // The ASCII kernels: asciiPrefix() returns the number of leading ASCII bytes, widenAscii() copies the leading ASCII
+  // bytes to UTF-32 and returns how many it copied.
+  typedef size_t (*AsciiPrefixFunction)(const unsigned char *s, size_t n);
+  typedef size_t (*WidenAsciiFunction)(const unsigned char *s, size_t n, Utf32Unit *out);
+
+  size_t asciiPrefixScalar(const unsigned char *s, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      uint64_t word;
+      std::memcpy(&word, s + i, 8);
+      if ((word & 0x8080808080808080ULL) != 0) {
+        break;
+      }
+    }
+    while (i < n && s[i] < 0x80) {
+      ++i;
+    }
+    return i;
+  }
+
+  size_t widenAsciiScalar(const unsigned char *s, size_t n, Utf32Unit *out) {
+    size_t count = asciiPrefixScalar(s, n);
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = static_cast<Utf32Unit>(s[i]);
+    }
+    return count;
+  }
+
+#ifdef ANTLR4_UNICODE_X64
+
+  inline size_t countTrailingZeros(uint32_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return index;
+#else
+    return static_cast<size_t>(__builtin_ctz(value));
+#endif
+  }
+
+  // SSE2 is part of x86-64, so these need no check.
+  size_t asciiPrefixSSE2(const unsigned char *s, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+      uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i))));
+      if (mask != 0) {
+        return i + countTrailingZeros(mask);
+      }
+    }
+    return i + asciiPrefixScalar(s + i, n - i);
+  }
+
+  size_t widenAsciiSSE2(const unsigned char *s, size_t n, Utf32Unit *out) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+      __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+      if (_mm_movemask_epi8(bytes) != 0) {
+        break;
+      }
+
+      __m128i low = _mm_unpacklo_epi8(bytes, zero);
+      __m128i high = _mm_unpackhi_epi8(bytes, zero);
+      __m128i *target = reinterpret_cast<__m128i *>(out + i);
+      _mm_storeu_si128(target, _mm_unpacklo_epi16(low, zero));
+      _mm_storeu_si128(target + 1, _mm_unpackhi_epi16(low, zero));
+      _mm_storeu_si128(target + 2, _mm_unpacklo_epi16(high, zero));
+      _mm_storeu_si128(target + 3, _mm_unpackhi_epi16(high, zero));
+    }
+    return i + widenAsciiScalar(s + i, n - i, out + i);
+  }
+
+  ANTLR4_TARGET_AVX2 size_t asciiPrefixAVX2(const unsigned char *s, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+      uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i))));
+      if (mask != 0) {
+        return i + countTrailingZeros(mask);
+      }
+    }
+    return i + asciiPrefixSSE2(s + i, n - i);
+  }
+
+  ANTLR4_TARGET_AVX2 size_t widenAsciiAVX2(const unsigned char *s, size_t n, Utf32Unit *out) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+      if (_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i))) != 0) {
+        break;
+      }
+
+      __m256i *target = reinterpret_cast<__m256i *>(out + i);
+      for (size_t j = 0; j < 4; ++j) {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(s + i + 8 * j));
+        _mm256_storeu_si256(target + j, _mm256_cvtepu8_epi32(bytes));
+      }
+    }
+    return i + widenAsciiSSE2(s + i, n - i, out + i);
+  }
+
+  bool cpuSupportsAVX2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+      return false;
+    }
+
+    // The OS must save the AVX registers (OSXSAVE and AVX set, XMM and YMM state enabled).
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6) {
+      return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+  }
+
+#endif
+
+  struct Kernels {
+    AsciiPrefixFunction asciiPrefix;
+    WidenAsciiFunction widenAscii;
+
+    Kernels() {
+#ifdef ANTLR4_UNICODE_X64
+      if (cpuSupportsAVX2()) {
+        asciiPrefix = asciiPrefixAVX2;
+        widenAscii = widenAsciiAVX2;
+      } else {
+        asciiPrefix = asciiPrefixSSE2;
+        widenAscii = widenAsciiSSE2;
+      }
+#else
+      asciiPrefix = asciiPrefixScalar;
+      widenAscii = widenAsciiScalar;
+#endif
+    }
+  };
+
+  const Kernels& kernels() {
+    static const Kernels instance;
+    return instance;
+  }
+
+  // Copies the leading ASCII code points of [in, in + n) to out and returns how many it copied.
+  size_t narrowAscii(const unsigned char *in, size_t n, char *out) {
+    size_t count = kernels().asciiPrefix(in, n);
+    std::memcpy(out, in, count);
+    return count;
+  }
+
+  size_t narrowAscii(const char16_t *in, size_t n, char *out) {
+    size_t i = 0;
+#ifdef ANTLR4_UNICODE_X64
+    const __m128i nonAscii = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+      __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+      __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 8));
+      __m128i test = _mm_and_si128(_mm_or_si128(low, high), nonAscii);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(test, zero)) != 0xFFFF) {
+        break;
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(low, high));
+    }
+#endif
+    for (; i < n && in[i] < 0x80; ++i) {
+      out[i] = static_cast<char>(in[i]);
+    }
+    return i;
+  }
+
+  size_t narrowAscii(const char32_t *in, size_t n, char *out) {
+    size_t i = 0;
+#ifdef ANTLR4_UNICODE_X64
+    const __m128i nonAscii = _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+      const __m128i *source = reinterpret_cast<const __m128i *>(in + i);
+      __m128i a = _mm_loadu_si128(source);
+      __m128i b = _mm_loadu_si128(source + 1);
+      __m128i c = _mm_loadu_si128(source + 2);
+      __m128i d = _mm_loadu_si128(source + 3);
+      __m128i test = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), nonAscii);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi32(test, zero)) != 0xFFFF) {
+        break;
+      }
+      __m128i words = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), words);
+    }
+#endif
+    for (; i < n && in[i] < 0x80; ++i) {
+      out[i] = static_cast<char>(in[i]);
+    }
+    return i;
+  }
+
+  inline size_t decodeSequence(const unsigned char *s, size_t available, uint32_t &codePoint) {
+    // Lead byte ranges and the allowed range of the second byte, which excludes overlong forms, surrogates
+    // and code points above U+10FFFF.
+    uint32_t c = s[0];
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    size_t length;
+    if (c < 0x80) {
+      codePoint = c;
+      return 1;
+    } else if (c >= 0xC2 && c <= 0xDF) {
+      length = 2;
+      c &= 0x1F;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+      length = 3;
+      if (c == 0xE0) {
+        low = 0xA0;
+      } else if (c == 0xED) {
+        high = 0x9F;
+      }
+      c &= 0x0F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+      length = 4;
+      if (c == 0xF0) {
+        low = 0x90;
+      } else if (c == 0xF4) {
+        high = 0x8F;
+      }
+      c &= 0x07;
+    } else {
+      return 0;
+    }
+
+    if (length > available || s[1] < low || s[1] > high) {
+      return 0;
+    }
+    for (size_t i = 1; i < length; ++i) {
+      if ((s[i] & 0xC0) != 0x80) {
+        return 0;
+      }
+      c = (c << 6) | (s[i] & 0x3F);
+    }
+
+    codePoint = c;
+    return length;
+  }
+
+  // Writes the UTF-8 form of codePoint to out and returns its length.
+  size_t encodeCodePoint(uint32_t codePoint, char *out) {
+    if (codePoint < 0x80) {
+      out[0] = static_cast<char>(codePoint);
+      return 1;
+    }
+    if (codePoint < 0x800) {
+      out[0] = static_cast<char>(0xC0 | (codePoint >> 6));
+      out[1] = static_cast<char>(0x80 | (codePoint & 0x3F));
+      return 2;
+    }
+    if (codePoint < 0x10000) {
+      if (codePoint >= 0xD800 && codePoint <= 0xDFFF) {
+        throw std::range_error("Cannot encode surrogate code point as UTF-8");
+      }
+      out[0] = static_cast<char>(0xE0 | (codePoint >> 12));
+      out[1] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+      out[2] = static_cast<char>(0x80 | (codePoint & 0x3F));
+      return 3;
+    }
+    if (codePoint > 0x10FFFF) {
+      throw std::range_error("Cannot encode invalid code point as UTF-8");
+    }
+    out[0] = static_cast<char>(0xF0 | (codePoint >> 18));
+    out[1] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (codePoint & 0x3F));
+    return 4;
+  }
+
+  template<typename T>
+  std::string encode(const T *first, const T *last) {
+    size_t n = static_cast<size_t>(last - first);
+
+    // Sized for ASCII, grown when other characters need more room.
+    std::string result(n, '\0');
+    size_t i = 0;
+    size_t o = 0;
+    while (i < n) {
+      if (o + (n - i) > result.size()) {
+        result.resize(std::max(result.size() * 2, o + (n - i)));
+      }
+      size_t count = narrowAscii(first + i, n - i, &result[o]);
+      i += count;
+      o += count;
+
+      while (i < n && static_cast<uint32_t>(first[i]) >= 0x80) {
+        if (o + 4 > result.size()) {
+          result.resize(std::max(result.size() * 2, o + 4 + (n - i)));
+        }
+        o += encodeCodePoint(static_cast<uint32_t>(first[i]), &result[o]);
+        ++i;
+      }
+    }
+    result.resize(o);
+    return result;
+  }
+
+  // Decodes UTF-8 text which was validated by scanUtf8() into target.
+  template<typename T>
+  void decodeValid(const unsigned char *s, size_t n, T *target) {
+    const Kernels &k = kernels();
+    size_t i = 0;
+    while (i < n) {
+      if (s[i] < 0x80) {
+        size_t run = k.asciiPrefix(s + i, n - i);
+        for (size_t j = 0; j < run; ++j) {
+          target[j] = static_cast<T>(s[i + j]);
+        }
+        target += run;
+        i += run;
+        continue;
+      }
+
+      uint32_t codePoint;
+      i += decodeSequence(s + i, n - i, codePoint);
+      *target++ = static_cast<T>(codePoint);
+    }
+  }
+
+} // namespace
+
+size_t antlrcpp::asciiPrefixLength(const char *first, const char *last) {
+  return kernels().asciiPrefix(reinterpret_cast<const unsigned char *>(first), static_cast<size_t>(last - first));
+}
+
+size_t antlrcpp::decodeUtf8Sequence(const unsigned char *s, size_t available, uint32_t &codePoint) {
+  return decodeSequence(s, available, codePoint);
+}
+
+UTF32String antlrcpp::decodeUtf8(const char *first, const char *last) {
+  UTF32String result;
+  decodeUtf8(first, last, result);
+  return result;
+}
+
+void antlrcpp::decodeUtf8(const char *first, const char *last, UTF32String &target) {
+  const unsigned char *s = reinterpret_cast<const unsigned char *>(first);
+  size_t n = static_cast<size_t>(last - first);
+  if (n == 0) {
+    return;
+  }
+
+  // There are at most as many code points as bytes.
+  size_t base = target.size();
+  target.resize(base + n);
+
+  const Kernels &k = kernels();
+  Utf32Unit *out = &target[base];
+  size_t i = 0;
+  size_t o = 0;
+  while (i < n) {
+    if (s[i] < 0x80) {
+      // Short ASCII runs between other characters are copied directly, longer ones by the vector kernel.
+      size_t end = std::min(n, i + 16);
+      while (i < end && s[i] < 0x80) {
+        out[o++] = static_cast<Utf32Unit>(s[i++]);
+      }
+      if (i == end && i < n) {
+        size_t count = k.widenAscii(s + i, n - i, out + o);
+        i += count;
+        o += count;
+      }
+      continue;
+    }
+
+    uint32_t codePoint;
+    size_t length = decodeSequence(s + i, n - i, codePoint);
+    if (length == 0) {
+      target.resize(base);
+      throw std::range_error("Invalid UTF-8 sequence at byte " + std::to_string(i));
+    }
+    out[o++] = static_cast<Utf32Unit>(codePoint);
+    i += length;
+  }
+
+  target.resize(base + o);
+}
+
+size_t antlrcpp::scanUtf8(const char *first, const char *last, uint32_t &maxCodePoint) {
+  const unsigned char *s = reinterpret_cast<const unsigned char *>(first);
+  size_t n = static_cast<size_t>(last - first);
+  const Kernels &k = kernels();
+
+  maxCodePoint = 0;
+  size_t count = 0;
+  size_t i = 0;
+  while (i < n) {
+    if (s[i] < 0x80) {
+      size_t run = k.asciiPrefix(s + i, n - i);
+      maxCodePoint = std::max(maxCodePoint, static_cast<uint32_t>(0x7F));
+      count += run;
+      i += run;
+      continue;
+    }
+
+    uint32_t codePoint;
+    size_t length = decodeSequence(s + i, n - i, codePoint);
+    if (length == 0) {
+      throw std::range_error("Invalid UTF-8 sequence at byte " + std::to_string(i));
+    }
+    maxCodePoint = std::max(maxCodePoint, codePoint);
+    ++count;
+    i += length;
+  }
+
+  return count;
+}
+
+void antlrcpp::decodeUtf8(const char *first, const char *last, char *target) {
+  decodeValid(reinterpret_cast<const unsigned char *>(first), static_cast<size_t>(last - first), target);
+}
+
+void antlrcpp::decodeUtf8(const char *first, const char *last, char16_t *target) {
+  decodeValid(reinterpret_cast<const unsigned char *>(first), static_cast<size_t>(last - first), target);
+}
+
+void antlrcpp::decodeUtf8(const char *first, const char *last, UTF32String::value_type *target) {
+  decodeValid(reinterpret_cast<const unsigned char *>(first), static_cast<size_t>(last - first), target);
+}
+
+std::string antlrcpp::encodeUtf8(const unsigned char *first, const unsigned char *last) {
+  return encode(first, last);
+}
+
+std::string antlrcpp::encodeUtf8(const char16_t *first, const char16_t *last) {
+  return encode(first, last);
+}
+
+std::string antlrcpp::encodeUtf8(const char32_t *first, const char32_t *last) {
+  return encode(first, last);
+}
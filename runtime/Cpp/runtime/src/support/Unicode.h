@@ -0,0 +1,48 @@
+/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#pragma once
+
+#include "antlr4-common.h"
+
+namespace antlrcpp {
+
+  // UTF-8 validation and conversion for the char streams. Runs of ASCII characters are processed 16 or 32 at a time
+  // with SSE2 or AVX2 on x86-64 (AVX2 is used if the CPU supports it), other platforms use a portable implementation
+  // that tests 8 bytes at a time.
+
+  /// Returns the number of bytes at the start of [first, last) which are ASCII (below 0x80).
+  ANTLR4CPP_PUBLIC size_t asciiPrefixLength(const char *first, const char *last);
+
+  /// Decodes a single UTF-8 sequence from {@code s}, which has {@code available} bytes. Returns the length of the
+  /// sequence and stores the code point in {@code codePoint}, or returns 0 if the sequence is invalid (which includes
+  /// overlong forms, surrogates and code points above U+10FFFF).
+  ANTLR4CPP_PUBLIC size_t decodeUtf8Sequence(const unsigned char *s, size_t available, uint32_t &codePoint);
+
+  /// Validates and decodes UTF-8 text. Throws std::range_error if the text is not valid UTF-8.
+  ANTLR4CPP_PUBLIC UTF32String decodeUtf8(const char *first, const char *last);
+
+  /// Like decodeUtf8() above, but appends the code points to {@code target}. {@code target} is left unchanged if the
+  /// text is not valid.
+  ANTLR4CPP_PUBLIC void decodeUtf8(const char *first, const char *last, UTF32String &target);
+
+  /// Validates UTF-8 text without decoding it. Returns the number of code points and stores the largest one in
+  /// {@code maxCodePoint} (0 for empty text). Throws std::range_error if the text is not valid UTF-8.
+  ANTLR4CPP_PUBLIC size_t scanUtf8(const char *first, const char *last, uint32_t &maxCodePoint);
+
+  /// Decodes UTF-8 text which was validated with scanUtf8() into {@code target}, which must have room for all code
+  /// points. With scanUtf8() the caller can pick the narrowest target which holds the largest code point (Latin-1,
+  /// UCS-2 or UTF-32) and allocate it once, without decoding to UTF-32 first.
+  ANTLR4CPP_PUBLIC void decodeUtf8(const char *first, const char *last, char *target);
+  ANTLR4CPP_PUBLIC void decodeUtf8(const char *first, const char *last, char16_t *target);
+  ANTLR4CPP_PUBLIC void decodeUtf8(const char *first, const char *last, UTF32String::value_type *target);
+
+  /// Encodes Latin-1, UCS-2 or UTF-32 code points as UTF-8. Throws std::range_error for values which are not valid
+  /// code points (surrogates and values above U+10FFFF).
+  ANTLR4CPP_PUBLIC std::string encodeUtf8(const unsigned char *first, const unsigned char *last);
+  ANTLR4CPP_PUBLIC std::string encodeUtf8(const char16_t *first, const char16_t *last);
+  ANTLR4CPP_PUBLIC std::string encodeUtf8(const char32_t *first, const char32_t *last);
+
+} // namespace antlrcpp
@@ -0,0 +1,76 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#pragma once
+
+#include "tree/ParseTree.h"
+#include "tree/ParseTreeProperty.h"
+
+namespace antlr4 {
+namespace tree {
+
+  /// A ParseTreeProperty which keeps the values of nodes created by a ParseTreeTracker (which includes all nodes
+  /// built by a parser) in a vector indexed by the node ordinal (see ParseTree::getOrdinal()). An access is then an
+  /// array index instead of a hash lookup. Nodes without an ordinal are kept in the hash map of ParseTreeProperty.
+  ///
+  /// Ordinals are unique only among the nodes of one tracker, and are given out again after the tracker was reset.
+  /// So all nodes annotated in one property must come from the same parser and the same parse. Call clear() (or
+  /// use a new property) for the next parse. Call reserve() with Parser::getTreeTracker().size() to allocate the
+  /// table once for a whole tree.
+  template<typename V>
+  class ANTLR4CPP_PUBLIC DenseParseTreeProperty : public ParseTreeProperty<V> {
+  public:
+    virtual V get(ParseTree *node) override {
+      size_t ordinal = node->getOrdinal();
+      if (ordinal == INVALID_INDEX) {
+        return ParseTreeProperty<V>::get(node);
+      }
+      if (ordinal >= _values.size()) {
+        return V();
+      }
+      return _values[ordinal];
+    }
+
+    virtual void put(ParseTree *node, V value) override {
+      size_t ordinal = node->getOrdinal();
+      if (ordinal == INVALID_INDEX) {
+        ParseTreeProperty<V>::put(node, std::move(value));
+        return;
+      }
+      if (ordinal >= _values.size()) {
+        _values.resize(ordinal + 1);
+      }
+      _values[ordinal] = std::move(value);
+    }
+
+    virtual V removeFrom(ParseTree *node) override {
+      size_t ordinal = node->getOrdinal();
+      if (ordinal == INVALID_INDEX) {
+        return ParseTreeProperty<V>::removeFrom(node);
+      }
+      if (ordinal >= _values.size()) {
+        return V();
+      }
+      V value = std::move(_values[ordinal]);
+      _values[ordinal] = V();
+      return value;
+    }
+
+    /// Makes room for the values of the nodes with ordinals below {@code count}.
+    virtual void reserve(size_t count) override {
+      _values.reserve(count);
+    }
+
+    virtual void clear() override {
+      ParseTreeProperty<V>::clear();
+      _values.clear();
+    }
+
+  protected:
+    std::vector<V> _values;
+  };
+
+} // namespace tree
+} // namespace antlr4
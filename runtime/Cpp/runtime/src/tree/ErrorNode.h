@@ -12,6 +12,7 @@ namespace tree {
 
   class ANTLR4CPP_PUBLIC ErrorNode : public virtual TerminalNode {
   public:
+    ErrorNode();
     ~ErrorNode() override;
   };
 
@@ -0,0 +1,158 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#include "ParserRuleContext.h"
+#include "Token.h"
+#include "tree/ErrorNode.h"
+#include "tree/ParseTreeListener.h"
+
+#include "tree/FlatParseTree.h"
+
+using namespace antlr4;
+using namespace antlr4::tree;
+
+ParseTree* FlatParseTree::Node::getTree() const {
+  switch (type) {
+    case ParseTreeType::RULE:
+      return context;
+    case ParseTreeType::TERMINAL:
+      return terminal;
+    case ParseTreeType::ERROR:
+      return error;
+    default:
+      return other;
+  }
+}
+
+FlatParseTree::FlatParseTree(ParseTree *root) {
+  if (root == nullptr) {
+    return;
+  }
+
+  // Preorder walk with the node positions of the open subtrees on a stack. The kinds of the nodes are determined
+  // once here, so the passes over the array need no casts.
+  struct Frame {
+    ParseTree *tree;
+    size_t position;
+    size_t nextChild;
+  };
+  std::vector<Frame> stack;
+
+  ParseTree *current = root;
+  while (true) {
+    if (current != nullptr) {
+      Node node;
+      node.type = current->getTreeType();
+      node.ruleIndex = INVALID_INDEX;
+      node.tokenIndex = INVALID_INDEX;
+      node.subtreeSize = 1;
+      node.childCount = 0;
+      node.other = current;
+
+      switch (node.type) {
+        case ParseTreeType::RULE: {
+          ParserRuleContext *context = dynamic_cast<ParserRuleContext *>(current);
+          if (context == nullptr) {
+            node.type = ParseTreeType::OTHER;
+            node.ruleIndex = static_cast<RuleContext *>(current)->getRuleIndex();
+            break;
+          }
+          node.context = context;
+          node.ruleIndex = context->getRuleIndex();
+          if (context->start != nullptr) {
+            node.tokenIndex = context->start->getTokenIndex();
+          }
+          break;
+        }
+
+        case ParseTreeType::TERMINAL:
+          node.terminal = static_cast<TerminalNode *>(current);
+          node.tokenIndex = node.terminal->getSymbol()->getTokenIndex();
+          break;
+
+        case ParseTreeType::ERROR:
+          node.error = dynamic_cast<ErrorNode *>(current);
+          node.tokenIndex = node.error->getSymbol()->getTokenIndex();
+          break;
+
+        default:
+          break;
+      }
+
+      if (!stack.empty()) {
+        _nodes[stack.back().position].childCount++;
+      }
+      stack.push_back({ current, _nodes.size(), 0 });
+      _nodes.push_back(node);
+    }
+
+    // Descend into the next child of the innermost open node, or close it.
+    Frame &top = stack.back();
+    if (top.nextChild < top.tree->children.size()) {
+      current = top.tree->children[top.nextChild++];
+      continue;
+    }
+
+    _nodes[top.position].subtreeSize = _nodes.size() - top.position;
+    stack.pop_back();
+    if (stack.empty()) {
+      break;
+    }
+    current = nullptr;
+  }
+}
+
+const std::vector<FlatParseTree::Node>& FlatParseTree::getNodes() const {
+  return _nodes;
+}
+
+size_t FlatParseTree::size() const {
+  return _nodes.size();
+}
+
+const FlatParseTree::Node& FlatParseTree::operator [] (size_t index) const {
+  return _nodes[index];
+}
+
+void FlatParseTree::walk(ParseTreeListener *listener) const {
+  // The contexts which still have to be exited, with the end of their subtrees.
+  std::vector<std::pair<size_t, ParserRuleContext *>> open;
+
+  for (size_t i = 0; i < _nodes.size(); ++i) {
+    while (!open.empty() && open.back().first == i) {
+      ParserRuleContext *context = open.back().second;
+      open.pop_back();
+      context->exitRule(listener);
+      listener->exitEveryRule(context);
+    }
+
+    const Node &node = _nodes[i];
+    switch (node.type) {
+      case ParseTreeType::RULE:
+        listener->enterEveryRule(node.context);
+        node.context->enterRule(listener);
+        open.push_back({ i + node.subtreeSize, node.context });
+        break;
+
+      case ParseTreeType::TERMINAL:
+        listener->visitTerminal(node.terminal);
+        break;
+
+      case ParseTreeType::ERROR:
+        listener->visitErrorNode(node.error);
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  while (!open.empty()) {
+    ParserRuleContext *context = open.back().second;
+    open.pop_back();
+    context->exitRule(listener);
+    listener->exitEveryRule(context);
+  }
+}
@@ -0,0 +1,83 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#pragma once
+
+#include "tree/ParseTree.h"
+
+namespace antlr4 {
+namespace tree {
+
+  /// A finished parse tree frozen into an array of its nodes in preorder. Each entry has the node kind, rule index,
+  /// token index and subtree size, so passes over the tree read one contiguous array instead of following child
+  /// pointers from node to node, and need no RTTI to tell the kinds of nodes apart.
+  ///
+  /// The children of the node at index i start at i + 1; each next sibling follows the subtree of the one before.
+  /// The entries point to the original nodes, so the tree must stay alive (and unchanged) while this is used.
+  class ANTLR4CPP_PUBLIC FlatParseTree {
+  public:
+    struct Node {
+      ParseTreeType type;
+
+      /// The rule index of a context, INVALID_INDEX for other nodes.
+      size_t ruleIndex;
+
+      /// The index of the token of a terminal or error node, and of the start token of a context (or INVALID_INDEX).
+      size_t tokenIndex;
+
+      /// The number of nodes in the subtree of this node, including itself.
+      size_t subtreeSize;
+
+      /// The number of direct children.
+      size_t childCount;
+
+      /// The original node. Which member is set depends on the type: RULE nodes have a context, except for rule
+      /// nodes which are not a ParserRuleContext; these are stored with type OTHER.
+      union {
+        ParserRuleContext *context;
+        TerminalNode *terminal;
+        ErrorNode *error;
+        ParseTree *other;
+      };
+
+      ParseTree* getTree() const;
+    };
+
+    explicit FlatParseTree(ParseTree *root);
+
+    const std::vector<Node>& getNodes() const;
+    size_t size() const;
+    const Node& operator [] (size_t index) const;
+
+    /// Sends the events of ParseTreeWalker::walk() to {@code listener}, in the same order, without recursion and
+    /// without a dynamic_cast per node.
+    void walk(ParseTreeListener *listener) const;
+
+    /// Computes a value for every node from the values of its children, bottom-up and without recursion, and returns
+    /// the value of the root. {@code function} is called as {@code function(node, childValues, childCount)} with a
+    /// pointer to the values of the node's children, in order. Values are kept on a stack of T, so nothing is
+    /// allocated per node unless T allocates.
+    template<typename T, typename Function>
+    T reduce(Function function) const {
+      std::vector<T> values;
+      for (size_t i = _nodes.size(); i-- > 0;) {
+        const Node &node = _nodes[i];
+
+        // The values of the children are on top of the stack, last child at the bottom.
+        auto first = values.end() - static_cast<ssize_t>(node.childCount);
+        std::reverse(first, values.end());
+        T value = function(node, node.childCount > 0 ? &*first : nullptr, node.childCount);
+        values.erase(first, values.end());
+        values.push_back(std::move(value));
+      }
+      return values.empty() ? T() : std::move(values.back());
+    }
+
+  private:
+    std::vector<Node> _nodes;
+  };
+
+} // namespace tree
+} // namespace antlr4
@@ -23,10 +23,11 @@ void IterativeParseTreeWalker::walk(ParseTreeListener *listener, ParseTree *t) c
 
   while (currentNode != nullptr) {
     // pre-order visit
-    if (antlrcpp::is<ErrorNode *>(currentNode)) {
+    ParseTreeType type = currentNode->getTreeType();
+    if (type == ParseTreeType::ERROR) {
       listener->visitErrorNode(dynamic_cast<ErrorNode *>(currentNode));
-    } else if (antlrcpp::is<TerminalNode *>(currentNode)) {
-      listener->visitTerminal((TerminalNode *)currentNode);
+    } else if (type == ParseTreeType::TERMINAL) {
+      listener->visitTerminal(static_cast<TerminalNode *>(currentNode));
     } else {
       enterRule(listener, currentNode);
     }
@@ -43,7 +44,8 @@ void IterativeParseTreeWalker::walk(ParseTreeListener *listener, ParseTree *t) c
     // No child nodes, so walk tree.
     do {
       // post-order visit
-      if (!antlrcpp::is<TerminalNode *>(currentNode)) {
+      type = currentNode->getTreeType();
+      if (type != ParseTreeType::TERMINAL && type != ParseTreeType::ERROR) {
         exitRule(listener, currentNode);
       }
 
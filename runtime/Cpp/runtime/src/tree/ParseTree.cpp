@@ -3,13 +3,52 @@
  * can be found in the LICENSE.txt file in the project root.
  */
 
+#include "Exceptions.h"
+
 #include "tree/ParseTree.h"
 
+using namespace antlr4;
 using namespace antlr4::tree;
 
-ParseTree::ParseTree() : parent(nullptr) {
+ParseTree::ParseTree() : parent(nullptr), _treeType(ParseTreeType::OTHER), _ordinal(INVALID_INDEX) {
+}
+
+void ParseTree::appendText(std::string &text) {
+  text += getText();
 }
 
 bool ParseTree::operator == (const ParseTree &other) const {
   return &other == this;
 }
+
+ParseTreeTracker::ParseTreeTracker() : _arena(nullptr) {
+}
+
+void ParseTreeTracker::reset() {
+  if (_arena != nullptr) {
+    for (auto * entry : _allocated)
+      entry->~ParseTree();
+    _allocated.clear();
+    _arena->reset();
+    return;
+  }
+
+  for (auto * entry : _allocated)
+    delete entry;
+  _allocated.clear();
+}
+
+size_t ParseTreeTracker::size() const {
+  return _allocated.size();
+}
+
+void ParseTreeTracker::setArena(ParseTreeArena *arena) {
+  if (!_allocated.empty()) {
+    throw IllegalStateException("the arena of a parse tree tracker can only be changed while it holds no nodes");
+  }
+  _arena = arena;
+}
+
+ParseTreeArena* ParseTreeTracker::getArena() const {
+  return _arena;
+}
@@ -6,10 +6,19 @@
 #pragma once
 
 #include "support/Any.h"
+#include "tree/ParseTreeArena.h"
 
 namespace antlr4 {
 namespace tree {
 
+  /// The kind of a parse tree node, see ParseTree::getTreeType().
+  enum class ParseTreeType : size_t {
+    OTHER = 0, // A class derived directly from ParseTree.
+    RULE = 1,
+    TERMINAL = 2,
+    ERROR = 3,
+  };
+
   /// An interface to access the tree of <seealso cref="RuleContext"/> objects created
   /// during a parse that makes the data structure look like a simple parse tree.
   /// This node represents both internal nodes, rule invocations,
@@ -57,6 +66,11 @@ namespace tree {
     /// comments if they are sent to parser on hidden channel.
     virtual std::string getText() = 0;
 
+    /// Appends the text returned by getText() to {@code text}. Rule contexts let their children append to the same
+    /// string and terminal nodes append views of their token text, so the text of a subtree is built without a
+    /// temporary string per node. Classes overriding getText() must override this too.
+    virtual void appendText(std::string &text);
+
     /**
      * Return an {@link Interval} indicating the index in the
      * {@link TokenStream} of the first and last token associated with this
@@ -74,27 +88,66 @@ namespace tree {
      * EOF is unspecified.</p>
      */
     virtual misc::Interval getSourceInterval() = 0;
+
+    /// Returns whether this node is a RuleContext, a TerminalNode or an ErrorNode (which is a TerminalNode too).
+    /// The kind is set by the constructors of these classes, so testing it is an integer compare instead of a
+    /// dynamic_cast. A node of kind RULE can be cast to RuleContext and a node of kind TERMINAL or ERROR to
+    /// TerminalNode with static_cast.
+    ParseTreeType getTreeType() const {
+      return _treeType;
+    }
+
+    /// Returns the position of this node in the creation order of the ParseTreeTracker which created it, or
+    /// INVALID_INDEX for nodes created otherwise. The ordinals of the nodes of a tracker are dense (0..n-1), so they
+    /// can index side tables like DenseParseTreeProperty. They start again at 0 after the tracker was reset.
+    size_t getOrdinal() const {
+      return _ordinal;
+    }
+
+  protected:
+    ParseTreeType _treeType;
+
+  private:
+    friend class ParseTreeTracker;
+
+    size_t _ordinal;
   };
 
   // A class to help managing ParseTree instances without the need of a shared_ptr.
   class ANTLR4CPP_PUBLIC ParseTreeTracker {
   public:
+    ParseTreeTracker();
+
     template<typename T, typename ... Args>
     T* createInstance(Args&& ... args) {
       static_assert(std::is_base_of<ParseTree, T>::value, "Argument must be a parse tree type");
-      T* result = new T(args...);
+      T* result;
+      if (_arena != nullptr) {
+        result = new (_arena->allocate(sizeof(T), alignof(T))) T(args...);
+      } else {
+        result = new T(args...);
+      }
+      result->_ordinal = _allocated.size();
       _allocated.push_back(result);
       return result;
     }
 
-    void reset() {
-      for (auto * entry : _allocated)
-        delete entry;
-      _allocated.clear();
-    }
+    void reset();
+
+    /// Returns the number of nodes held, which is also the ordinal the next node gets.
+    size_t size() const;
+
+    /// Makes the tracker take the memory for new nodes from {@code arena} instead of allocating each node on its own.
+    /// The nodes are still destroyed one by one in reset(), but their memory is given back to the arena as a whole.
+    /// The arena is not owned by the tracker. It must stay alive until the tracker was reset or destroyed, and it must
+    /// not be used by another tracker meanwhile. Pass nullptr to allocate nodes individually again.
+    /// @throws IllegalStateException if the tracker holds nodes.
+    void setArena(ParseTreeArena *arena);
+    ParseTreeArena* getArena() const;
 
   private:
     std::vector<ParseTree *> _allocated;
+    ParseTreeArena *_arena;
   };
 
 
@@ -0,0 +1,75 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#include "tree/ParseTreeArena.h"
+
+using namespace antlr4::tree;
+
+namespace {
+
+  size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+  }
+
+}
+
+ParseTreeArena::ParseTreeArena(size_t blockSize) : _blockSize(blockSize), _largeSize(0), _current(0), _offset(0) {
+}
+
+ParseTreeArena::~ParseTreeArena() {
+  reset();
+  for (char *block : _blocks) {
+    delete[] block;
+  }
+}
+
+void* ParseTreeArena::allocate(size_t size, size_t alignment) {
+  if (size + alignment > _blockSize) {
+    // Oversized requests get a block of their own.
+    char *block = new char[size + alignment]; /* mem-check: deleted in reset() */
+    _largeBlocks.push_back(block);
+    _largeSize += size + alignment;
+    return reinterpret_cast<char *>(alignUp(reinterpret_cast<size_t>(block), alignment));
+  }
+
+  while (true) {
+    if (_current == _blocks.size()) {
+      _blocks.push_back(new char[_blockSize]); /* mem-check: deleted in clear() or the destructor */
+      _offset = 0;
+    }
+
+    size_t base = reinterpret_cast<size_t>(_blocks[_current]);
+    size_t address = alignUp(base + _offset, alignment);
+    if (address + size <= base + _blockSize) {
+      _offset = address + size - base;
+      return reinterpret_cast<char *>(address);
+    }
+
+    ++_current;
+    _offset = 0;
+  }
+}
+
+void ParseTreeArena::reset() {
+  for (char *block : _largeBlocks) {
+    delete[] block;
+  }
+  _largeBlocks.clear();
+  _largeSize = 0;
+  _current = 0;
+  _offset = 0;
+}
+
+void ParseTreeArena::clear() {
+  reset();
+  for (size_t i = 1; i < _blocks.size(); ++i) {
+    delete[] _blocks[i];
+  }
+  _blocks.resize(std::min(_blocks.size(), static_cast<size_t>(1)));
+}
+
+size_t ParseTreeArena::getCapacity() const {
+  return _blocks.size() * _blockSize + _largeSize;
+}
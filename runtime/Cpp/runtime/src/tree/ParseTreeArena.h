@@ -0,0 +1,51 @@
+﻿/* Copyright (c) 2012-2017 The ANTLR Project. All rights reserved.
+ * Use of this file is governed by the BSD 3-clause license that
+ * can be found in the LICENSE.txt file in the project root.
+ */
+
+#pragma once
+
+#include "antlr4-common.h"
+
+namespace antlr4 {
+namespace tree {
+
+  /// Memory for parse tree nodes, handed out from large blocks. A ParseTreeTracker which uses an arena destroys
+  /// its nodes in reset() and then resets the arena, which makes all blocks available again at once instead of
+  /// freeing every node. The blocks are kept, so once a parser (or an arena handed from parser to parser) has
+  /// warmed up, building a tree does not allocate memory for the nodes anymore.
+  ///
+  /// An arena may only be used by one tracker at a time, and it is not thread-safe.
+  class ANTLR4CPP_PUBLIC ParseTreeArena {
+  public:
+    explicit ParseTreeArena(size_t blockSize = 64 * 1024);
+    ParseTreeArena(const ParseTreeArena &) = delete;
+    ~ParseTreeArena();
+
+    ParseTreeArena& operator = (const ParseTreeArena &) = delete;
+
+    void* allocate(size_t size, size_t alignment);
+
+    /// Makes the memory of all blocks available again. Everything allocated before must have been destroyed.
+    /// Blocks for allocations larger than the block size are freed.
+    void reset();
+
+    /// Like reset(), but also frees all blocks except the first one, e.g. after an unusually large parse.
+    void clear();
+
+    /// Returns the total size of the blocks held by this arena.
+    size_t getCapacity() const;
+
+  private:
+    const size_t _blockSize;
+    std::vector<char *> _blocks;
+    std::vector<char *> _largeBlocks;
+    size_t _largeSize;
+
+    /// The index of the block allocations are taken from, and the offset of the free space in it.
+    size_t _current;
+    size_t _offset;
+  };
+
+} // namespace tree
+} // namespace antlr4
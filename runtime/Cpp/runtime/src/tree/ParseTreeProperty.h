@@ -26,24 +26,47 @@ namespace tree {
   /// You would make one decl (values here) in the listener and use lots of times
   /// in your event methods.
   /// </summary>
+  ///
+  /// The values are kept in a hash map, so an access costs O(1). For trees built by a parser
+  /// DenseParseTreeProperty is faster still.
   template<typename V>
   class ANTLR4CPP_PUBLIC ParseTreeProperty {
   public:
     virtual ~ParseTreeProperty() {}
+
+    /// Returns the value of {@code node}, or a default constructed value if it has none.
     virtual V get(ParseTree *node) {
-      return _annotations[node];
+      auto iterator = _annotations.find(node);
+      if (iterator == _annotations.end()) {
+        return V();
+      }
+      return iterator->second;
     }
     virtual void put(ParseTree *node, V value) {
-      _annotations[node] = value;
+      _annotations[node] = std::move(value);
     }
     virtual V removeFrom(ParseTree *node) {
-      auto value = _annotations[node];
-      _annotations.erase(node);
+      auto iterator = _annotations.find(node);
+      if (iterator == _annotations.end()) {
+        return V();
+      }
+      V value = std::move(iterator->second);
+      _annotations.erase(iterator);
       return value;
     }
 
+    /// Makes room for the values of {@code count} nodes, so that annotating a tree of known size does not rehash.
+    virtual void reserve(size_t count) {
+      _annotations.reserve(count);
+    }
+
+    /// Removes all values.
+    virtual void clear() {
+      _annotations.clear();
+    }
+
   protected:
-    std::map<ParseTree*, V> _annotations;
+    std::unordered_map<ParseTree*, V> _annotations;
   };
 
 } // namespace tree
@@ -21,11 +21,11 @@ ParseTreeWalker::~ParseTreeWalker() {
 }
 
 void ParseTreeWalker::walk(ParseTreeListener *listener, ParseTree *t) const {
-  if (is<ErrorNode *>(t)) {
+  if (t->getTreeType() == ParseTreeType::ERROR) {
     listener->visitErrorNode(dynamic_cast<ErrorNode *>(t));
     return;
-  } else if (is<TerminalNode *>(t)) {
-    listener->visitTerminal(dynamic_cast<TerminalNode *>(t));
+  } else if (t->getTreeType() == ParseTreeType::TERMINAL) {
+    listener->visitTerminal(static_cast<TerminalNode *>(t));
     return;
   }
 
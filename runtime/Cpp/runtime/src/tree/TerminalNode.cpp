@@ -5,5 +5,9 @@
 
 #include "tree/TerminalNode.h"
 
+antlr4::tree::TerminalNode::TerminalNode() {
+  _treeType = ParseTreeType::TERMINAL;
+}
+
 antlr4::tree::TerminalNode::~TerminalNode() {
 }
@@ -38,9 +38,22 @@ antlrcpp::Any TerminalNodeImpl::accept(ParseTreeVisitor *visitor) {
 }
 
 std::string TerminalNodeImpl::getText() {
+  antlrcpp::StringView view;
+  if (symbol->getTextView(view)) {
+    return std::string(view);
+  }
   return symbol->getText();
 }
 
+void TerminalNodeImpl::appendText(std::string &text) {
+  antlrcpp::StringView view;
+  if (symbol->getTextView(view)) {
+    text.append(view.data(), view.size());
+  } else {
+    text += symbol->getText();
+  }
+}
+
 std::string TerminalNodeImpl::toStringTree(Parser * /*parser*/, bool /*pretty*/) {
   return toString();
 }